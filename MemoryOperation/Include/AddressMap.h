@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash map keyed by address (0 is reserved as the empty key).
+// Linear probing over a power-of-two table kept at most half full, so a lookup is one
+// multiply-shift and on average under two probes no matter how many entries there are.
+// No Windows dependency; copies are cheap enough to publish a new map per change.
+template<typename T>
+class AddressMap
+{
+public:
+    AddressMap() = default;
+    explicit AddressMap(size_t expected) { Rehash(expected * 2); }
+
+    // Inserts or replaces
+    void Insert(uintptr_t key, const T& value)
+    {
+        if (!key) return;
+        if ((count + 1) * 2 > slots.size()) Rehash((count + 1) * 2);
+
+        Slot& slot = slots[Probe(key)];
+        if (!slot.key) count++;
+        slot.key = key;
+        slot.value = value;
+    }
+
+    bool Erase(uintptr_t key)
+    {
+        if (!key || slots.empty()) return false;
+
+        size_t hole = Probe(key);
+        if (slots[hole].key != key) return false;
+
+        // Backward-shift deletion: pull later entries of the probe run into the hole so
+        // lookups never need tombstones
+        const size_t mask = slots.size() - 1;
+        for (size_t i = (hole + 1) & mask; slots[i].key; i = (i + 1) & mask) {
+            const size_t home = Home(slots[i].key);
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots[hole] = slots[i];
+                hole = i;
+            }
+        }
+        slots[hole] = Slot{};
+        count--;
+        return true;
+    }
+
+    const T* Find(uintptr_t key) const
+    {
+        if (!key || slots.empty()) return nullptr;
+        const Slot& slot = slots[Probe(key)];
+        return slot.key ? &slot.value : nullptr;
+    }
+
+    bool   Contains(uintptr_t key) const { return Find(key) != nullptr; }
+    size_t Size() const { return count; }
+
+    template<typename Fn>
+    void ForEach(Fn&& fn) const
+    {
+        for (const Slot& slot : slots) {
+            if (slot.key) fn(slot.key, slot.value);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        uintptr_t key = 0;
+        T         value{};
+    };
+
+    // Fibonacci hashing: the high bits of key * 2^64/phi
+    size_t Home(uintptr_t key) const
+    {
+        return static_cast<size_t>((uint64_t(key) * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    // Slot holding key, or the empty slot where it would go
+    size_t Probe(uintptr_t key) const
+    {
+        const size_t mask = slots.size() - 1;
+        size_t i = Home(key);
+        while (slots[i].key && slots[i].key != key) i = (i + 1) & mask;
+        return i;
+    }
+
+    void Rehash(size_t minimum)
+    {
+        size_t capacity = 16;
+        int bits = 4;
+        while (capacity < minimum) {
+            capacity <<= 1;
+            bits++;
+        }
+
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(capacity);
+        shift = 64 - bits;
+        count = 0;
+
+        for (const Slot& slot : old) {
+            if (slot.key) Insert(slot.key, slot.value);
+        }
+    }
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+    int    shift = 64;
+};
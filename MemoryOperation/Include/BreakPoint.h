@@ -1,30 +1,75 @@
 #pragma once
 #include <windows.h>
+#include "DebugRegisters.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
 class Breakpoint {
 public:
     typedef void (*Callback)(PCONTEXT ctx);
 
+    // One access to a watched range. Data breakpoints trap after the access, so pc is the
+    // instruction following the one that touched the memory.
+    struct WatchHit {
+        DWORD_PTR address = 0;   // watched address
+        DWORD_PTR pc = 0;
+        DWORD     threadId = 0;
+        uint64_t  oldValue = 0;  // value at the previous hit (or when the watch was set)
+        uint64_t  newValue = 0;
+    };
+    typedef void (*WatchCallback)(const WatchHit& hit, PCONTEXT ctx);
+
+    enum class Access {
+        Write,
+        ReadWrite,
+    };
+
     struct BPInfo {
         DWORD_PTR address = 0;
         Callback  callback = nullptr;
         int       index = -1;
         bool      enabled = false;
-        bool      singleStepping = false;
+
+        // data watchpoints only
+        DebugRegisters::Condition condition = DebugRegisters::Condition::Execute;
+        size_t        length = 1;
+        WatchCallback watchCallback = nullptr;
     };
 
+    static constexpr size_t kHitRingSize = 256;   // hits kept per thread until drained
+
 private:
-    static BPInfo s_breakpoints[4];
+    // The exception handler only reads an immutable Table. Set/Watch/Remove build a new one
+    // and publish it with one atomic pointer store; replaced tables are kept alive because
+    // a handler on another core may still be reading them.
+    struct Table {
+        BPInfo entries[4];
+    };
+    static std::atomic<const Table*> s_table;
+    static const Table& Current();
+    static void Publish(const Table& next);
+
     static bool s_handlerInstalled;
     static PVOID s_vehHandle;
 
     static void InstallHandler();
-    static int FindFreeDebugRegister();
-    static void ApplyBreakpointsToContext(CONTEXT& ctx);
+    static int FindFreeDebugRegister(const Table& table);
+    static void ApplyBreakpointsToContext(CONTEXT& ctx, const Table& table);
+    static void ClearBreakpointInContext(CONTEXT& ctx, int drIndex);
+
+    // Runs edit on the debug registers of every thread in the process, in one pass.
+    // Other threads are suspended only around their own Get/SetThreadContext.
+    typedef void (*ContextEdit)(CONTEXT& ctx, int drIndex);
+    static void EditAllThreads(ContextEdit edit, int drIndex);
+    static bool EditThread(HANDLE thread, ContextEdit edit, int drIndex);
+    static void ApplyEdit(CONTEXT& ctx, int drIndex);
+
     static void UpdateDebugRegisters();
     static void DisableBreakpoint(int drIndex);
     static void EnableBreakpoint(int drIndex);
     static LONG WINAPI ExceptionHandler(PEXCEPTION_POINTERS ex);
+    static void RecordWatchHit(const BPInfo& bp, PCONTEXT ctx);
 
 public:
     // Core control
@@ -34,7 +79,24 @@ public:
     static bool IsSet(DWORD_PTR address);
     static int  GetCount();
 
+    // Data watchpoint on a naturally aligned 1, 2, 4 or 8-byte range (8 only on x64).
+    // Shares the four debug registers with Set(); remove it with Remove(address).
+    // Every hit is logged into the hitting thread's ring, then callback (if any) is called
+    // from the exception handler, so it must be short.
+    static bool Watch(DWORD_PTR address, size_t length, Access access, WatchCallback callback = nullptr);
+
+    // Moves the logged hits of every thread out of their rings, oldest first per thread
+    static std::vector<WatchHit> DrainHits();
+    // Hits lost because a thread's ring was full
+    static uint64_t GetDroppedHits();
+
     // Utility functions
     static void PrintRegisters(PCONTEXT ctx);
-    static BPInfo* GetBreakpointInfo(DWORD_PTR address);
+    // Entry of the table current at the time of the call; stays readable after removal
+    static const BPInfo* GetBreakpointInfo(DWORD_PTR address);
+
+    // Loads the current breakpoints into the calling thread's debug registers.
+    // Threads created later get this from the library's TLS callback; call it from
+    // DLL_THREAD_ATTACH if the host module disabled thread notifications.
+    static void ApplyToCurrentThread();
 };
\ No newline at end of file
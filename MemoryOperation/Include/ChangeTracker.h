@@ -0,0 +1,46 @@
+#pragma once
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reports which bytes of a region changed since the previous Refresh().
+// For memory allocated with ChangeTracker::Allocate (MEM_WRITE_WATCH) the kernel keeps a dirty
+// bit per page: Refresh() fetches and resets those bits in one GetWriteWatch call and compares
+// only the dirty pages against the snapshot, so its cost follows what was written, not the
+// region size. Any other region falls back to comparing every page.
+class ChangeTracker
+{
+public:
+    struct Change
+    {
+        uintptr_t address;
+        size_t    size;    // run of consecutive changed bytes
+    };
+
+    // Write-watched, committed read/write memory; release with Free
+    static void* Allocate(size_t size);
+    static void  Free(void* address);
+
+    // Takes the initial snapshot. Throws std::invalid_argument for an empty range.
+    ChangeTracker(void* base, size_t size);
+
+    // Appends the changed runs since the last call (or construction) and updates the snapshot
+    bool Refresh(std::vector<Change>& changes);
+
+    bool   IsWriteWatched() const { return writeWatched; }
+    size_t GetLastDirtyPages() const { return lastDirtyPages; }   // pages compared by the last Refresh
+    size_t GetPageCount() const { return pageCount; }
+
+private:
+    uintptr_t            base;
+    size_t               size;
+    size_t               pageSize;
+    size_t               pageCount;
+    bool                 writeWatched = false;
+    size_t               lastDirtyPages = 0;
+    std::vector<uint8_t> snapshot;
+    std::vector<PVOID>   dirty;   // GetWriteWatch output, sized for every page
+
+    void ComparePage(size_t page, std::vector<Change>& changes);
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <Windows.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Small executable allocations (trampolines, stubs) carved out of 64 KB blocks.
+// On x64 the block is placed within rel32 reach of the requested address so a 5-byte
+// jump can get there. Allocations are never released: a thread may still be executing
+// inside a trampoline long after its hook was removed.
+class CodeAllocator
+{
+public:
+    static uint8_t* Allocate(size_t size, uintptr_t nearAddress);
+
+private:
+    struct Block
+    {
+        uintptr_t base = 0;
+        size_t    used = 0;
+        size_t    size = 0;
+    };
+
+    static uintptr_t AllocateBlockNear(uintptr_t nearAddress, size_t size);
+
+    static std::vector<Block> blocks;
+    static std::mutex         mutex;
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <Windows.h>
+#include <cstdint>
+#include <vector>
+
+// Writes into code pages: unprotect, store, restore protection, flush the i-cache.
+// Writes that fit inside one aligned 8-byte word (16 on x64) are done with a single
+// interlocked compare-exchange, so a thread executing the range sees either all of the
+// old bytes or all of the new ones.
+class CodePatcher
+{
+public:
+    static bool Write(uintptr_t address, const void* data, size_t size);
+
+    struct Edit
+    {
+        uintptr_t   address = 0;
+        const void* data = nullptr;
+        size_t      size = 0;
+        bool        written = false;   // set by WriteBatch
+    };
+
+    // Write() for many ranges: edits on the same page share one VirtualProtect pair and
+    // one i-cache flush. Returns the number of edits written.
+    static size_t WriteBatch(std::vector<Edit>& edits);
+
+    // True if Write() can publish this range with one atomic store
+    static bool IsAtomic(uintptr_t address, size_t size);
+
+private:
+    static bool Store(uintptr_t address, const void* data, size_t size);
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Moves the first instructions of a function somewhere else (a trampoline) so they still
+// behave the same: relative branches and calls are re-targeted, short branches widened to
+// rel32, RIP-relative operands re-based, and a jump back to the rest of the function is appended.
+class CodeRelocator
+{
+public:
+    // Worst-case output for relocating a 5-byte window plus the jump back
+    static constexpr size_t kMaxTrampolineSize = 128;
+    static constexpr size_t kMaxJumpSize = 14;
+
+    // Relocates the whole instructions covering at least minLength bytes at source into out,
+    // which will execute at outAddress. Returns the bytes written (0 on failure, e.g. LOOP/JCXZ,
+    // a branch back into the stolen bytes, or a function shorter than minLength);
+    // *stolen receives how many source bytes were consumed.
+    static size_t Relocate(uintptr_t source, size_t minLength, uint8_t* out, size_t capacity,
+        uintptr_t outAddress, size_t* stolen);
+
+    // jmp rel32 when reachable, otherwise (x64) jmp [rip+0] followed by the absolute address
+    static size_t EmitJump(uint8_t* out, uintptr_t from, uintptr_t to);
+
+    static bool   InRel32(uintptr_t from, uintptr_t to);
+};
@@ -1,15 +1,84 @@
 #pragma once
 #include <windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
+// Turns faults (access violation, illegal instruction, integer divide...) into recoveries:
+// - inside a RecoveryPoint on the faulting thread, execution resumes at that point with Faulted() set
+//   (vectored handler, so it wins over any frame handler below the point);
+// - otherwise, only if no __try/catch frame claimed the fault, the faulting instruction is skipped,
+//   its length taken from InstructionDecoder (unhandled exception filter, so not under a debugger).
+// Debug, breakpoint, C++ and any other exception codes are passed on untouched.
+// Every fault is counted per site (faulting address) in a fixed lock-free table; a site that
+// faults more than kBurstLimit times within kWindowMs is passed on instead of suppressed, so a
+// fault loop ends in a normal crash rather than a core spinning in the handler.
 class CrashSuppressor {
-private:
-    static PVOID s_vectoredHandler;
-
 public:
+    static constexpr size_t   kSiteCount = 256;    // power of two
+    static constexpr size_t   kMaxProbe = 16;
+    static constexpr uint32_t kBurstLimit = 1000;
+    static constexpr DWORD    kWindowMs = 1000;
+
+    struct FaultSite {
+        uintptr_t address = 0;
+        DWORD     code = 0;        // last exception code seen at this address
+        uint32_t  count = 0;       // faults suppressed
+        uint32_t  passed = 0;      // faults passed on by the rate limit
+    };
+
+    // Like sigsetjmp/siglongjmp: a fault on this thread while the point is alive restores the
+    // context captured by CRASH_RECOVERY_TRY and makes it return false.
+    //   CrashSuppressor::RecoveryPoint point;
+    //   if (CRASH_RECOVERY_TRY(point)) { ...risky... } else { ...point.GetCode()... }
+    // Destructors of the frames between the fault and the point do not run, and locals
+    // changed inside the guarded block are indeterminate after a recovery.
+    class RecoveryPoint {
+    public:
+        RecoveryPoint();
+        ~RecoveryPoint();
+        RecoveryPoint(const RecoveryPoint&) = delete;
+        RecoveryPoint& operator=(const RecoveryPoint&) = delete;
+
+        bool      Faulted() const { return faulted; }
+        DWORD     GetCode() const { return code; }
+        uintptr_t GetAddress() const { return address; }
+
+        CONTEXT context{};
+
+    private:
+        friend class CrashSuppressor;
+
+        RecoveryPoint* previous;
+        volatile bool  faulted = false;
+        DWORD          code = 0;
+        uintptr_t      address = 0;
+
+        static inline thread_local RecoveryPoint* current = nullptr;
+    };
+
     static void Install();
     static void Remove();
     static bool IsInstalled();
 
+    // Bytes to skip for the instruction at code, 0 if it must not be skipped (undecodable,
+    // or a return/jump whose fall-through is not where execution would have gone)
+    static size_t SkipLength(const uint8_t* code, size_t available);
+
+    static std::vector<FaultSite> GetSites();
+    static uint64_t GetUntrackedFaults();   // faults at new sites while the table was full
+    static void ResetSites();
+    static void Dump();
+
 private:
+    static PVOID s_vectoredHandler;
+    static LPTOP_LEVEL_EXCEPTION_FILTER s_previousFilter;
+
+    static bool IsOwnedCode(DWORD code);
+    static bool CountFault(uintptr_t address, DWORD code);
+    static bool SkipInstruction(PCONTEXT ctx, uintptr_t pc);
     static LONG NTAPI ExceptionHandler(PEXCEPTION_POINTERS ExceptionInfo);
-};
\ No newline at end of file
+    static LONG WINAPI UnhandledFilter(PEXCEPTION_POINTERS ExceptionInfo);
+};
+
+#define CRASH_RECOVERY_TRY(Point) (RtlCaptureContext(&(Point).context), !(Point).Faulted())
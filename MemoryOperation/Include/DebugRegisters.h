@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// DR7/DR6 bit layout of the x86 debug registers.
+// Pure functions on the raw register values, no Windows types, so the encoding can be
+// checked on any host.
+class DebugRegisters
+{
+public:
+    // RW field of a DR7 slot
+    enum class Condition : uint8_t
+    {
+        Execute   = 0,
+        Write     = 1,
+        Io        = 2,
+        ReadWrite = 3,
+    };
+
+    static constexpr int      kCount = 4;
+    static constexpr uint64_t kExactBits = 0x300;        // LE | GE
+    static constexpr uint64_t kSingleStepBit = 1ull << 14; // DR6.BS
+
+    // LEN field for a 1/2/4/8-byte range, -1 for any other size
+    static constexpr int EncodeLength(size_t length)
+    {
+        switch (length) {
+        case 1: return 0;
+        case 2: return 1;
+        case 8: return 2;
+        case 4: return 3;
+        default: return -1;
+        }
+    }
+
+    static constexpr size_t DecodeLength(uint64_t bits)
+    {
+        constexpr size_t lengths[4] = { 1, 2, 8, 4 };
+        return lengths[bits & 3];
+    }
+
+    // Watched ranges must be naturally aligned to their length
+    static constexpr bool IsValid(uintptr_t address, Condition condition, size_t length)
+    {
+        if (condition == Condition::Execute) return length == 1;
+        if (condition == Condition::Io) return false;
+        return EncodeLength(length) >= 0 && (address & (length - 1)) == 0;
+    }
+
+    // Sets L<index>, RW<index> and LEN<index>; other slots are left alone
+    static constexpr uint64_t Enable(uint64_t dr7, int index, Condition condition = Condition::Execute, size_t length = 1)
+    {
+        const int len = condition == Condition::Execute ? 0 : EncodeLength(length);
+        if (index < 0 || index >= kCount || len < 0) return dr7;
+
+        dr7 = Disable(dr7, index);
+        dr7 |= 1ull << (index * 2);
+        dr7 |= uint64_t(static_cast<uint8_t>(condition)) << FieldShift(index);
+        dr7 |= uint64_t(len) << (FieldShift(index) + 2);
+        return dr7 | kExactBits;
+    }
+
+    // Clears L<index>, G<index>, RW<index> and LEN<index>
+    static constexpr uint64_t Disable(uint64_t dr7, int index)
+    {
+        if (index < 0 || index >= kCount) return dr7;
+        dr7 &= ~(3ull << (index * 2));
+        dr7 &= ~(0xFull << FieldShift(index));
+        return dr7;
+    }
+
+    static constexpr bool IsEnabled(uint64_t dr7, int index)
+    {
+        return index >= 0 && index < kCount && (dr7 & (3ull << (index * 2))) != 0;
+    }
+
+    static constexpr Condition GetCondition(uint64_t dr7, int index)
+    {
+        return static_cast<Condition>((dr7 >> FieldShift(index)) & 3);
+    }
+
+    static constexpr size_t GetLength(uint64_t dr7, int index)
+    {
+        return DecodeLength(dr7 >> (FieldShift(index) + 2));
+    }
+
+    // Lowest slot reported by DR6.B0-B3, -1 if none
+    static constexpr int HitIndex(uint64_t dr6)
+    {
+        for (int i = 0; i < kCount; i++) {
+            if (dr6 & (1ull << i)) return i;
+        }
+        return -1;
+    }
+
+    static constexpr bool IsSingleStep(uint64_t dr6) { return (dr6 & kSingleStepBit) != 0; }
+
+private:
+    static constexpr int FieldShift(int index) { return 16 + index * 4; }
+};
+
+static_assert(DebugRegisters::Enable(0, 0) == 0x301);
+static_assert(DebugRegisters::Enable(0, 1, DebugRegisters::Condition::Write, 4) == (0x304 | (0xDull << 20)));
+static_assert(DebugRegisters::Enable(0, 3, DebugRegisters::Condition::ReadWrite, 8) == (0x340 | (0xBull << 28)));
+static_assert(DebugRegisters::Disable(DebugRegisters::Enable(0, 2, DebugRegisters::Condition::Write, 2), 2) == 0x300);
+static_assert(DebugRegisters::GetLength(DebugRegisters::Enable(0, 1, DebugRegisters::Condition::Write, 8), 1) == 8);
@@ -1,8 +1,10 @@
 #include "MemoryOperator.h"
+#include "HookStats.h"
 
 
 /**
  * Declare a hook with standard calling conventions.
+ * With MEMOP_HOOK_INSTRUMENTATION on, also declares Name##Stats for HOOK_SCOPE/CALL_ORIGINAL.
  * @param Name The prefix for the macro, and string name of hook/patch.
  * @param Ret The return type. (ex. int)
  * @param CallType The calling convention of the original function. (ex. __cdecl)
@@ -13,6 +15,7 @@
     static inline uintptr_t Name##Address = 0; \
     static inline Name##_t Name##Original = nullptr; \
     static inline WinDetour* Name##Detour = nullptr; \
+    MEMOP_DECLARE_HOOK_STATS(Name) \
     static Ret CallType Name##Hook(__VA_ARGS__);
 
 
@@ -21,12 +24,15 @@
     static inline uintptr_t Name##Address{}; \
     static inline Name##_t Name##Original{}; \
     static inline WinDetour* Name##Detour{}; \
+    MEMOP_DECLARE_HOOK_STATS(Name) \
     static Ret HookCallType Name##Hook(const void* p_this, int edx, __VA_ARGS__);
 
 
 
  /**
   * Install a hook with a pre-defined address and apply it.
+  * Inside MemoryOperator::BeginHookTransaction()/CommitHookTransaction() the detour is only
+  * queued, so a block of installs is attached in a single transaction.
   * @param Name The prefix for the macro, and string name of hook/patch.
   * @param AddressValue The memory address of the function to hook.
   */
@@ -37,7 +43,11 @@
         Name##Detour = MemoryOperator::CreateDetour(#Name, (uintptr_t)&Name##Original, \
             (uintptr_t)Name##Hook, true); \
         \
-        if (Name##Detour && !Name##Detour->Apply()) \
+        if (Name##Detour && MemoryOperator::InHookTransaction()) \
+        { \
+            MemoryOperator::QueueHook(#Name); \
+        } \
+        else if (Name##Detour && !Name##Detour->Apply()) \
         { \
             std::cout << "[!] Failed to apply " << #Name << " detour\n"; \
         } \
@@ -46,4 +56,49 @@
             std::cout << "[+] " << #Name << " detour applied at 0x" \
                       << std::hex << AddressValue << "\n"; \
         } \
+    }
+
+
+ /**
+  * Install a native inline hook (no Detours transaction) and apply it.
+  * Name##Original points at the trampoline before the jump is written, so the hook can call it
+  * as soon as it is reached.
+  * @param Name The prefix for the macro, and string name of hook.
+  * @param AddressValue The memory address of the function to hook.
+  */
+#define INSTALL_INLINE_HOOK_ADDRESS(Name, AddressValue) \
+    { \
+        Name##Address = AddressValue; \
+        InlineHook* Name##Inline = MemoryOperator::CreateInlineHook(#Name, (uintptr_t)AddressValue, \
+            (uintptr_t)Name##Hook, true); \
+        \
+        if (!Name##Inline) \
+        { \
+            std::cout << "[!] Failed to create " << #Name << " inline hook\n"; \
+        } \
+        else \
+        { \
+            Name##Original = Name##Inline->GetOriginal<Name##_t>(); \
+            if (!Name##Inline->Apply()) \
+                std::cout << "[!] Failed to apply " << #Name << " inline hook\n"; \
+            else \
+                std::cout << "[+] " << #Name << " inline hook applied at 0x" \
+                          << std::hex << AddressValue << "\n"; \
+        } \
+    }
+
+
+ /**
+  * Install a block of hooks in one transaction and report the ones that failed.
+  * @param ... INSTALL_HOOK_ADDRESS(...) statements.
+  */
+#define INSTALL_HOOKS_BATCH(...) \
+    { \
+        MemoryOperator::BeginHookTransaction(); \
+        __VA_ARGS__ \
+        for (const auto& result : MemoryOperator::CommitHookTransaction()) \
+        { \
+            if (!result.Succeeded()) \
+                std::cout << "[!] Failed to apply " << result.name << " detour (rc=" << result.error << ")\n"; \
+        } \
     }
\ No newline at end of file
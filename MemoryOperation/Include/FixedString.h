@@ -0,0 +1,13 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+// String literal usable as a template argument: Hook<"Tick", ...>, Field<"health", ...>
+template<size_t N>
+struct FixedString
+{
+    char value[N]{};
+    constexpr FixedString(const char (&str)[N]) { std::copy_n(str, N, value); }
+    constexpr std::string_view View() const { return { value, N - 1 }; }
+};
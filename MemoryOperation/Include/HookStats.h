@@ -0,0 +1,176 @@
+#pragma once
+#include <Windows.h>
+#include <intrin.h>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Compile-time switch for hook instrumentation. When 0 (default) HOOK_SCOPE expands to
+// nothing and CALL_ORIGINAL to a plain call, so instrumented hooks cost nothing.
+#ifndef MEMOP_HOOK_INSTRUMENTATION
+#define MEMOP_HOOK_INSTRUMENTATION 0
+#endif
+
+// Per-hook call counts and rdtsc latency histograms (log2 buckets of cycles), split into
+// time spent in the hook body and time spent in the original function.
+// Every thread writes to its own cache-line aligned shard with plain relaxed stores;
+// while more than kShards threads are alive the extra ones share one overflow shard
+// updated with atomic adds. Shards are recycled when their thread exits.
+class HookStats
+{
+public:
+    static constexpr size_t kBuckets = 40;   // 2^40 cycles is several minutes
+    static constexpr size_t kShards = 16;
+    static_assert(kShards < 32, "freeShards is a 32-bit mask");
+
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> hook[kBuckets]{};
+        std::atomic<uint64_t> original[kBuckets]{};
+    };
+
+    struct Site
+    {
+        explicit Site(const char* name);
+
+        const char*       name;
+        std::atomic<bool> enabled{ true };
+        Shard             shards[kShards + 1];   // last one is shared
+    };
+
+    struct Summary
+    {
+        std::string name;
+        bool        enabled = false;
+        uint64_t    calls = 0;
+        double      hookP50 = 0, hookP99 = 0;          // nanoseconds
+        double      originalP50 = 0, originalP99 = 0;
+    };
+
+    // Times one hook invocation; CALL_ORIGINAL adds the original's time to it
+    class Scope
+    {
+    public:
+        explicit Scope(Site& site)
+            : site(site.enabled.load(std::memory_order_relaxed) && globalEnabled.load(std::memory_order_relaxed) ? &site : nullptr)
+            , start(this->site ? __rdtsc() : 0) {}
+
+        ~Scope()
+        {
+            if (!site) return;
+            const uint64_t total = __rdtsc() - start;
+            Record(*site, total > originalCycles ? total - originalCycles : 0, originalCycles, hadOriginal);
+        }
+
+        template<typename F, typename... Args>
+        decltype(auto) CallOriginal(F fn, Args&&... args)
+        {
+            struct Timer
+            {
+                Scope& scope;
+                uint64_t begin;
+                ~Timer() { if (scope.site) { scope.originalCycles += __rdtsc() - begin; scope.hadOriginal = true; } }
+            } timer{ *this, site ? __rdtsc() : 0 };
+            return fn(std::forward<Args>(args)...);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Site*    site;
+        uint64_t start;
+        uint64_t originalCycles = 0;
+        bool     hadOriginal = false;
+    };
+
+    // Runtime switches: per hook by name, and for every hook at once
+    static bool SetEnabled(const std::string& name, bool enabled);
+    static void SetAllEnabled(bool enabled) { globalEnabled.store(enabled, std::memory_order_relaxed); }
+
+    static std::vector<Summary> Snapshot();
+    static void Dump();
+    static void Reset();
+
+private:
+    static void Record(Site& site, uint64_t hookCycles, uint64_t originalCycles, bool hadOriginal)
+    {
+        Shard& s = site.shards[ShardIndex()];
+        const size_t hb = Bucket(hookCycles);
+        if (&s != &site.shards[kShards]) {
+            // owned by this thread alone: no locked instructions needed
+            s.calls.store(s.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            s.hook[hb].store(s.hook[hb].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (hadOriginal) {
+                const size_t ob = Bucket(originalCycles);
+                s.original[ob].store(s.original[ob].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            s.calls.fetch_add(1, std::memory_order_relaxed);
+            s.hook[hb].fetch_add(1, std::memory_order_relaxed);
+            if (hadOriginal) s.original[Bucket(originalCycles)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t Bucket(uint64_t cycles)
+    {
+        const size_t b = std::bit_width(cycles);
+        return b < kBuckets ? b : kBuckets - 1;
+    }
+
+    // A thread's private shard goes back to freeShards when the thread exits, so
+    // short-lived threads do not use up the private shards for good
+    struct ShardOwner
+    {
+        size_t index = ClaimShard();
+        ~ShardOwner()
+        {
+            if (index < kShards) freeShards.fetch_or(1u << index, std::memory_order_release);
+            index = kShards;   // hooks hit later in thread teardown use the shared shard
+        }
+    };
+
+    static size_t ShardIndex()
+    {
+        thread_local ShardOwner owner;
+        return owner.index;
+    }
+
+    static size_t ClaimShard()
+    {
+        uint32_t mask = freeShards.load(std::memory_order_relaxed);
+        while (mask && !freeShards.compare_exchange_weak(mask, mask & (mask - 1), std::memory_order_acquire, std::memory_order_relaxed)) {}
+        return mask ? static_cast<size_t>(std::countr_zero(mask)) : kShards;
+    }
+
+    static double Percentile(const uint64_t (&histogram)[kBuckets], double p);
+    static double CyclesPerNanosecond();
+
+    static std::atomic<bool>   globalEnabled;
+    static std::atomic<uint32_t> freeShards;   // bit i set: shard i has no owner
+};
+
+#if MEMOP_HOOK_INSTRUMENTATION
+#define MEMOP_DECLARE_HOOK_STATS(Name) static inline HookStats::Site Name##Stats{ #Name };
+
+/**
+ * Time the enclosing hook body. Put it first in Name##Hook.
+ * @param Name The hook name given to DECLARE_HOOK.
+ */
+#define HOOK_SCOPE(Name) HookStats::Scope memop_hook_scope_(Name##Stats)
+
+/**
+ * Call Name##Original and count its time separately from the hook body.
+ * Requires HOOK_SCOPE(Name) earlier in the same function.
+ */
+#define CALL_ORIGINAL(Name, ...) memop_hook_scope_.CallOriginal(Name##Original, __VA_ARGS__)
+#else
+#define MEMOP_DECLARE_HOOK_STATS(Name)
+#define HOOK_SCOPE(Name) ((void)0)
+#define CALL_ORIGINAL(Name, ...) Name##Original(__VA_ARGS__)
+#endif
@@ -0,0 +1,156 @@
+#pragma once
+#include "MemoryOperator.h"
+#include "FixedString.h"
+#include "HookStats.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+
+/**
+ * Typed replacement for DECLARE_HOOK/INSTALL_HOOK_ADDRESS.
+ *
+ *   static int __stdcall OnTick(float dt);
+ *   using TickHook = Hook<"Tick", &OnTick>;
+ *   int __stdcall OnTick(float dt) { return TickHook::Original(dt); }
+ *
+ * The original's signature and calling convention come from the replacement's type.
+ * A member function replacement hooks a __thiscall target: this arrives in ecx,
+ * no dummy edx parameter, and Original takes the object as its first argument.
+ *
+ *   using Tables = HookTable<TickHook, DamageHook>;
+ *   Tables::InstallAll([](std::string_view name) { return Lookup(name); });
+ */
+namespace hook_detail
+{
+    template<typename F>
+    struct Traits
+    {
+        static_assert(sizeof(F) == 0, "Hook replacement must be a function or member function pointer");
+    };
+
+    template<typename R, typename... A>
+    struct Traits<R(*)(A...)> { using Original = R(*)(A...); };
+
+#ifndef _WIN64
+    // x64 has one calling convention; these would be redefinitions there
+    template<typename R, typename... A>
+    struct Traits<R(__stdcall*)(A...)> { using Original = R(__stdcall*)(A...); };
+
+    template<typename R, typename... A>
+    struct Traits<R(__fastcall*)(A...)> { using Original = R(__fastcall*)(A...); };
+#endif
+
+    template<typename R, typename C, typename... A>
+    struct Traits<R(C::*)(A...)> { using Original = R(__thiscall*)(C*, A...); };
+
+    template<typename R, typename C, typename... A>
+    struct Traits<R(C::*)(A...) const> { using Original = R(__thiscall*)(const C*, A...); };
+
+    // Code address of a free function or a non-virtual member function
+    template<typename F>
+    uintptr_t CodeAddress(F fn)
+    {
+        static_assert(sizeof(F) >= sizeof(uintptr_t));
+        uintptr_t address = 0;
+        std::memcpy(&address, &fn, sizeof(address));
+        return address;
+    }
+}
+
+template<FixedString Name, auto Replacement>
+class Hook
+{
+public:
+    using Fn = typename hook_detail::Traits<decltype(Replacement)>::Original;
+
+    // Target before installation, the Detours trampoline afterwards
+    static inline Fn         Original = nullptr;
+    static inline uintptr_t  Address = 0;
+    static inline WinDetour* Detour = nullptr;
+
+#if MEMOP_HOOK_INSTRUMENTATION
+    static inline HookStats::Site Stats{ Name.value };
+#endif
+
+    static constexpr std::string_view GetName() { return Name.View(); }
+
+    // Registers the detour with MemoryOperator without attaching it
+    static bool Create(uintptr_t address)
+    {
+        if (!address) return false;
+
+        Address = address;
+        Original = reinterpret_cast<Fn>(address);
+        Detour = MemoryOperator::CreateDetour(std::string(GetName()), reinterpret_cast<uintptr_t>(&Original),
+            hook_detail::CodeAddress(Replacement), true);
+        return Detour != nullptr;
+    }
+
+    // Create + attach; only queued while a hook transaction is open
+    static bool Install(uintptr_t address)
+    {
+        if (!Create(address)) return false;
+
+        if (MemoryOperator::InHookTransaction()) {
+            MemoryOperator::QueueHook(std::string(GetName()));
+            return true;
+        }
+        return Detour->Apply();
+    }
+
+    static bool Uninstall() { return !Detour || Detour->Restore(); }
+    static bool IsInstalled() { return Detour && Detour->IsApplied(); }
+};
+
+// Compile-time list of hooks, installed together in one Detours transaction.
+template<typename... Hooks>
+class HookTable
+{
+public:
+    static constexpr std::array<std::string_view, sizeof...(Hooks)> names{ Hooks::GetName()... };
+
+    // resolve(name) returns the target address, 0 if it cannot be found.
+    // Returns one result per hook; unresolved ones fail with ERROR_INVALID_ADDRESS.
+    template<typename Resolver>
+    static std::vector<MemoryOperator::HookResult> InstallAll(Resolver&& resolve)
+    {
+        std::vector<MemoryOperator::HookResult> unresolved;
+        const bool nested = MemoryOperator::InHookTransaction();
+        if (!nested) MemoryOperator::BeginHookTransaction();
+
+        auto stage = [&]<typename H>() {
+            if (!H::Install(static_cast<uintptr_t>(resolve(H::GetName()))))
+                unresolved.push_back({ std::string(H::GetName()), ERROR_INVALID_ADDRESS });
+        };
+        (stage.template operator()<Hooks>(), ...);
+
+        // an enclosing transaction commits our queued hooks with its own
+        if (nested) return unresolved;
+
+        auto results = MemoryOperator::CommitHookTransaction();
+        results.insert(results.end(), unresolved.begin(), unresolved.end());
+        return results;
+    }
+
+    // Uses each hook's preset Hook::Address
+    static std::vector<MemoryOperator::HookResult> InstallAll()
+    {
+        std::vector<MemoryOperator::HookResult> unresolved;
+        const bool nested = MemoryOperator::InHookTransaction();
+        if (!nested) MemoryOperator::BeginHookTransaction();
+
+        ((Hooks::Install(Hooks::Address) ? void() : unresolved.push_back({ std::string(Hooks::GetName()), ERROR_INVALID_ADDRESS })), ...);
+
+        if (nested) return unresolved;
+
+        auto results = MemoryOperator::CommitHookTransaction();
+        results.insert(results.end(), unresolved.begin(), unresolved.end());
+        return results;
+    }
+
+    static std::vector<MemoryOperator::HookResult> UninstallAll()
+    {
+        return MemoryOperator::RestoreDetours({ std::string(Hooks::GetName())... });
+    }
+};
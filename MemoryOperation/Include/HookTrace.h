@@ -0,0 +1,126 @@
+#pragma once
+#include <Windows.h>
+#include <intrin.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Timeline of hook entry/exit across threads, written as Chrome trace-event JSON
+// (chrome://tracing, ui.perfetto.dev).
+// Recording appends a 24-byte event to a ring owned by the calling thread: an rdtsc, two plain
+// stores and a release store, no lock and no allocation after the thread's first event.
+// A flusher thread drains every ring to the file while recording; when a ring is full the event
+// is dropped and counted instead of blocking the hook. A ring is released when its thread exits
+// and handed to the next new thread once the flusher has drained it.
+class HookTrace
+{
+public:
+    enum class Phase : char
+    {
+        Begin   = 'B',
+        End     = 'E',
+        Instant = 'i',
+    };
+
+    static constexpr uint32_t kRingSize = 1 << 14;   // events per thread between flushes
+
+    // Opens path and starts the flusher; events recorded before Start are ignored
+    static bool Start(const std::string& path, DWORD flushIntervalMs = 10);
+    // Stops recording, drains what is left and closes the JSON document
+    static void Stop();
+    static bool IsRecording() { return recording.load(std::memory_order_relaxed); }
+
+    static uint64_t GetWrittenEvents();
+    static uint64_t GetDroppedEvents();
+
+    // name must outlive the trace (string literal, static storage): only the pointer is stored
+    static void Record(const char* name, Phase phase)
+    {
+        if (!IsRecording()) return;
+
+        Ring* ring = threadRing.ring ? threadRing.ring : CreateRing();
+        if (!ring) return;
+
+        const uint32_t head = ring->head.load(std::memory_order_relaxed);
+        if (head - ring->tail.load(std::memory_order_acquire) >= kRingSize) {
+            ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        Event& event = ring->events[head & (kRingSize - 1)];
+        event.tsc = __rdtsc();
+        event.name = name;
+        event.phase = phase;
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    // Begin on construction, End on destruction; decides once whether to record both
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name) : name(IsRecording() ? name : nullptr)
+        {
+            if (this->name) Record(this->name, Phase::Begin);
+        }
+        ~Scope()
+        {
+            if (name) Record(name, Phase::End);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+    };
+
+    // MidHook::Callback that records one event, e.g. a Begin at one address and an End at another:
+    //   static constexpr char kParse[] = "Parse";
+    //   MemoryOperator::CreateMidHook("ParseIn", a, HookTrace::MidEvent<kParse, HookTrace::Phase::Begin>, true);
+    template<const char* Name, Phase P>
+    static void MidEvent(PCONTEXT) { Record(Name, P); }
+
+private:
+    struct Event
+    {
+        uint64_t    tsc;
+        const char* name;
+        Phase       phase;
+    };
+
+    // Single producer (the owning thread), single consumer (the flusher)
+    struct Ring
+    {
+        std::atomic<uint32_t> head{ 0 };
+        std::atomic<uint32_t> tail{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<bool>     owned{ true };   // false once the thread exited
+        DWORD                 threadId = 0;
+        Ring*                 next = nullptr;
+        Event                 events[kRingSize];
+    };
+
+    // Releases the thread's ring from the TLS destructor
+    struct RingOwner
+    {
+        Ring* ring = nullptr;
+        bool  exited = false;   // hooks running later in thread teardown record nothing
+        ~RingOwner();
+    };
+
+    static Ring* CreateRing();
+    static size_t Drain(bool final);
+    static DWORD WINAPI FlusherThread(LPVOID);
+
+    static std::atomic<bool>  recording;
+    static std::atomic<Ring*> rings;
+    static thread_local RingOwner threadRing;
+};
+
+inline thread_local HookTrace::RingOwner HookTrace::threadRing;
+
+/**
+ * Record Begin/End events for the enclosing hook body while HookTrace is recording.
+ * @param Name The hook name given to DECLARE_HOOK (used as the event name).
+ */
+#define TRACE_SCOPE(Name) HookTrace::Scope memop_trace_scope_(#Name)
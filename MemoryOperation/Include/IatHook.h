@@ -0,0 +1,17 @@
+#pragma once
+#include "PointerHook.h"
+#include <string>
+
+// Redirects one import of a loaded module by rewriting its IAT entry.
+// Only calls made by that module through its import table are affected.
+class IatHook : public PointerHook
+{
+public:
+    // module: base of the importing module (0 = main executable)
+    // importModule: DLL the function is imported from, e.g. "kernel32.dll" (case-insensitive)
+    // function: imported name, or "#123" for an ordinal
+    IatHook(uintptr_t module, const std::string& importModule, const std::string& function, uintptr_t replacement);
+
+    // Address of the IAT slot, 0 if the module does not import the function
+    static uintptr_t FindSlot(uintptr_t module, const std::string& importModule, const std::string& function);
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include "MemoryOperation.h"
+
+// Native inline hook: the first instructions of the target are relocated into a trampoline
+// next to it and replaced by a 5-byte jmp to the detour (through a relay stub on x64 when the
+// detour is out of rel32 reach). Unlike WinDetour it needs no Detours transaction and no
+// thread suspension; the jump is published with one atomic store whenever the 5 bytes fit
+// in an aligned word (see CodePatcher).
+class InlineHook : public MemoryOperation
+{
+public:
+    // softToggle: route the jump through a ToggleStub so SetEnabled() is a flag store
+    // instead of rewriting the target
+    InlineHook(uintptr_t target, uintptr_t detour, bool softToggle = false);
+    ~InlineHook();
+
+    bool   Apply()   override;
+    bool   Restore() override;
+    size_t GetLength() const override { return kJumpSize; }
+
+    bool IsApplied() const { return is_modified; }
+
+    // Soft-toggled: flips the stub flag (applying the jump first if needed).
+    // Otherwise the same as Apply()/Restore().
+    bool SetEnabled(bool enabled);
+    bool IsEnabled() const;
+    bool IsSoftToggle() const { return toggle != nullptr; }
+
+    // Executes the stolen instructions and continues in the original function.
+    // Valid from construction on, so it can be stored before Apply().
+    uintptr_t GetTrampoline() const { return reinterpret_cast<uintptr_t>(trampoline); }
+
+    template<typename T>
+    T GetOriginal() const { return reinterpret_cast<T>(trampoline); }
+
+    static constexpr size_t kJumpSize = 5;
+
+private:
+    uint8_t*  trampoline = nullptr;
+    uintptr_t detourAddress = 0;
+    uint8_t*  toggle = nullptr;
+    uint8_t   jump[kJumpSize]{};
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Table-driven x86/x64 instruction length decoder.
+// Only decodes what hooking and code scanning need: the length of an instruction and where its
+// displacement, immediate and relative branch operand sit, not the full mnemonic.
+struct DecodedInstruction
+{
+    enum class Flow : uint8_t
+    {
+        None,           // falls through
+        Call,           // E8 rel
+        Jump,           // EB/E9 rel
+        CondJump,       // Jcc, LOOP/JCXZ
+        IndirectCall,   // FF /2, FF /3
+        IndirectJump,   // FF /4, FF /5
+        Return,         // RET/RETF/IRET
+        Interrupt       // INT3/INT n/UD2
+    };
+
+    uint8_t length = 0;
+    uint8_t opcode = 0;         // last opcode byte
+    uint8_t opcodeMap = 0;      // 0 = one byte, 1 = 0F, 2 = 0F 38, 3 = 0F 3A (VEX/EVEX/XOP keep their map)
+    uint8_t opcodeOffset = 0;   // offset of the last opcode byte
+    uint8_t modrm = 0;
+    bool    hasModrm = false;
+    bool    ripRelative = false;   // x64 [rip+disp32]
+    uint8_t rex = 0;
+    uint8_t dispOffset = 0;
+    uint8_t dispSize = 0;
+    uint8_t immOffset = 0;      // also the offset of a relative branch operand
+    uint8_t immSize = 0;
+    uint8_t relSize = 0;        // 1/2/4 when the immediate is a relative branch displacement
+    Flow    flow = Flow::None;
+
+    uint8_t ModrmReg() const { return (modrm >> 3) & 7; }
+
+    // Absolute destination of a relative branch, or of a RIP-relative operand.
+    uintptr_t BranchTarget(uintptr_t address, const uint8_t* code) const;
+    uintptr_t RipTarget(uintptr_t address, const uint8_t* code) const;
+};
+
+class InstructionDecoder
+{
+public:
+#ifdef _WIN64
+    static constexpr bool kNative64 = true;
+#else
+    static constexpr bool kNative64 = false;
+#endif
+
+    // Decodes one instruction from at most 'available' bytes. Returns false for invalid or truncated input.
+    static bool Decode(const uint8_t* code, size_t available, DecodedInstruction& out, bool x64 = kNative64);
+
+    // Length of the whole instructions covering at least minLength bytes, 0 on failure.
+    static size_t CoverLength(const uint8_t* code, size_t minLength, bool x64 = kNative64);
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include "MemoryOperation.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Watches applied operations for the host rewriting them (hot-reload, self-modifying code).
+// Each tracked range keeps a CRC32C of the bytes we wrote; Tick() re-hashes a slice of the
+// ranges per call so the check can run every frame under a fixed time budget.
+class IntegrityMonitor
+{
+public:
+    typedef void (*DriftCallback)(const std::string& name, MemoryOperation* op);
+
+    static void   SetCallback(DriftCallback callback);
+
+    // Tracks an applied operation. Patches are checked against new_bytes, anything else
+    // against the bytes currently in memory (e.g. the jump a detour just installed).
+    static bool   Track(const std::string& name, const std::shared_ptr<MemoryOperation>& op);
+    static void   Untrack(const std::string& name);
+
+    // Tracks every applied operation in MemoryOperator and drops restored/erased ones.
+    static size_t Sync();
+
+    // Checks ranges round-robin until the budget runs out; returns how many were checked.
+    static size_t Tick(uint32_t budgetMicroseconds);
+
+    static void   Clear();
+    static size_t GetTrackedCount() { return entries.size(); }
+
+    static uint32_t Crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+private:
+    struct Entry
+    {
+        std::string                    name;
+        std::weak_ptr<MemoryOperation> op;
+        uintptr_t                      address = 0;
+        size_t                         size = 0;
+        uint32_t                       hash = 0;
+        bool                           drifted = false;
+    };
+
+    static bool MakeEntry(const std::string& name, const std::shared_ptr<MemoryOperation>& op, Entry& entry);
+    static bool HashLive(uintptr_t address, size_t size, uint32_t* hash);
+
+    static std::vector<Entry> entries;
+    static size_t             cursor;
+    static DriftCallback      callback;
+};
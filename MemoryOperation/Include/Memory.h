@@ -17,6 +17,9 @@ public:
 
     static uintptr_t GetModuleAddress(std::string ModuleName);
 
+    // SizeOfImage from the PE header of a loaded module (0 if the header is unreadable)
+    static size_t GetModuleSize(uintptr_t moduleBase);
+
 
     template<typename T>
     static T Read(uintptr_t address);
@@ -24,6 +27,9 @@ public:
     // 2. Read raw bytes
     static std::vector<unsigned char> ReadBytes(uintptr_t address, size_t size);
 
+    // One guarded copy: false instead of a fault if any byte is unreadable (or freed meanwhile)
+    static bool ReadRaw(uintptr_t address, void* out, size_t size);
+
     // 3. Read ASCII string (null-terminated)
     static std::string ReadAscii(uintptr_t address, size_t max_length = 256);
 
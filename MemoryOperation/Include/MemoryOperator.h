@@ -2,8 +2,15 @@
 #include "MemoryOperation.h"
 #include "Patch.h"
 #include "WinDetour.h"
+#include "InlineHook.h"
+#include "MidHook.h"
+#include "IatHook.h"
+#include "VTableHook.h"
+#include "ModuleWatcher.h"
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <ranges>
 #include <iostream>
@@ -15,13 +22,66 @@ class MemoryOperator
 {
 public:
 
+	// Not synchronized: lock GetOperationsMutex() while iterating if other threads create operations
 	static std::map<std::string, std::shared_ptr<MemoryOperation>>& GetOperations() { return operations; }
+	static std::recursive_mutex& GetOperationsMutex() { return operationsMutex; }
+
+    // Bumped whenever an operation is added, replaced or erased, so callers can cache name lookups
+    static uint64_t GetRevision() { return revision; }
 
     static Patch*     CreatePatch(const std::string& name, uintptr_t address, const std::vector<byte>& bytes);
-    static WinDetour* CreateDetour(const std::string& name, uintptr_t target_addr, uintptr_t detour_addr, bool Override);
+    static WinDetour* CreateDetour(const std::string& name, uintptr_t target_addr, uintptr_t detour_addr, bool Override, bool softToggle = false);
+    static InlineHook* CreateInlineHook(const std::string& name, uintptr_t target_addr, uintptr_t detour_addr, bool Override, bool softToggle = false);
+
+    // Enables/disables a detour or inline hook; a flag store for soft-toggled ones
+    static bool       SetHookEnabled(const std::string& name, bool enabled);
+    static MidHook*   CreateMidHook(const std::string& name, uintptr_t address, MidHook::Callback callback, bool Override);
+
+    // Pointer-swap hooks: Apply/Restore are one interlocked store, no code is patched
+    static IatHook*   CreateIatHook(const std::string& name, uintptr_t module, const std::string& importModule,
+                                    const std::string& function, uintptr_t replacement, bool Override);
+    static VTableHook* CreateVTableHook(const std::string& name, uintptr_t vtable, size_t index, uintptr_t replacement, bool Override);
+    static VTableInstanceHook* CreateVTableInstanceHook(const std::string& name, uintptr_t object,
+                                    const std::vector<std::pair<size_t, uintptr_t>>& methods, bool Override);
+
+    // Module-relative operations stay pending until their module is mapped, then every
+    // operation of that module is resolved and applied in one pass.
+    // For detours, *original receives the target address right before the detour is attached.
+    static bool       CreateModulePatch(const std::string& name, const ModuleTarget& target, const std::vector<byte>& bytes);
+    static bool       CreateModuleDetour(const std::string& name, const ModuleTarget& target, void** original, uintptr_t detour_addr);
+    static size_t     ResolvePending(const std::string& module, uintptr_t moduleBase);
+    static std::vector<std::string> GetPendingModules();
+    static size_t     GetPendingCount();
+
+    // Batched detours: one Detours transaction (all threads updated) for the whole list.
+    struct HookResult
+    {
+        std::string name;
+        LONG        error = NO_ERROR;   // ERROR_INVALID_PARAMETER if the name is not a detour
+        bool Succeeded() const { return error == NO_ERROR; }
+    };
+    static std::vector<HookResult> ApplyDetours(const std::vector<std::string>& names);
+    static std::vector<HookResult> RestoreDetours(const std::vector<std::string>& names);
+
+    // Any mix of operations; the detours among them still share one transaction.
+    // Non-detours that fail report ERROR_WRITE_FAULT.
+    static std::vector<HookResult> ApplyOperations(const std::vector<std::string>& names);
+    static std::vector<HookResult> RestoreOperations(const std::vector<std::string>& names);
+
+    // While a hook transaction is open INSTALL_HOOK_ADDRESS only queues its detour;
+    // CommitHookTransaction attaches everything queued in a single transaction.
+    static void       BeginHookTransaction();
+    static bool       InHookTransaction() { return hookTransactionOpen; }
+    static void       QueueHook(const std::string& name);
+    static std::vector<HookResult> CommitHookTransaction();
+    static void       AbortHookTransaction();
 
     static Patch*     FindPatch(const std::string& name);
     static WinDetour* FindDetour(const std::string& name);
+    static InlineHook* FindInlineHook(const std::string& name);
+    static MidHook*   FindMidHook(const std::string& name);
+    static PointerHook* FindPointerHook(const std::string& name);
+    static VTableInstanceHook* FindVTableInstanceHook(const std::string& name);
 	static BOOL       DisposeAll(bool SaveActive, const std::vector<std::string>& ignoreList);
     static BOOL       ApplyAll(bool useSavedActive);
 
@@ -31,7 +91,60 @@ public:
     static bool DEBUG;
 
 private:
+    struct PendingOperation
+    {
+        std::string       name;
+        ModuleTarget      target;
+        std::vector<byte> bytes{};            // patch bytes, empty for detours
+        void**            original = nullptr; // detour trampoline storage, null for patches
+        uintptr_t         detour = 0;
+    };
+
+    static bool QueuePending(PendingOperation&& op);
+    static std::vector<HookResult> CommitDetours(const std::vector<std::string>& names, bool attach);
+    static std::vector<HookResult> CommitOperations(const std::vector<std::string>& names, bool apply);
+
+    // Constructs T in place under name; constructor exceptions are logged and yield nullptr
+    template<typename T, typename... Args>
+    static T* Emplace(const std::string& name, bool overrideExisting, Args&&... args)
+    {
+        std::lock_guard lock(operationsMutex);
+        if (operations.contains(name)) {
+            if (!overrideExisting) return nullptr;
+            operations.erase(name);
+            ++revision;
+        }
+
+        try {
+            auto op = std::make_shared<T>(std::forward<Args>(args)...);
+            T* raw = op.get();
+            operations.emplace(name, std::move(op));
+            ++revision;
+            return raw;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "MemoryOperator: cannot create '" << name << "': " << e.what() << "\n";
+            return nullptr;
+        }
+        catch (...) {
+            std::cerr << "MemoryOperator: unknown exception creating '" << name << "'\n";
+            return nullptr;
+        }
+    }
+
+    // operations and Savedoperations are guarded by operationsMutex; recursive because
+    // ResolvePending and the batch calls go back through Create*/Find*
     static std::map<std::string, std::shared_ptr<MemoryOperation>> operations;
     static std::map<std::string, std::shared_ptr<MemoryOperation>> Savedoperations;
+    static std::recursive_mutex operationsMutex;
+    static std::atomic<uint64_t> revision;
+
+    static bool hookTransactionOpen;
+    static std::vector<std::string> queuedHooks;
+
+    // keyed by lower-case module name; guarded by pendingMutex since ModuleWatcher
+    // resolves them on its own worker thread
+    static std::map<std::string, std::vector<PendingOperation>> pendingOperations;
+    static std::mutex pendingMutex;
 
 };
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include "MemoryOperation.h"
+
+// Hook at an arbitrary instruction without exceptions.
+// The instruction(s) at the address are relocated into a trampoline and replaced by a jmp to a
+// generated stub. The stub saves every general-purpose register, the flags and the SSE registers
+// into a CONTEXT, calls the callback, then loads the (possibly modified) registers back and
+// continues at ctx->Rip/Eip: the trampoline if the callback left it alone.
+// Costs one call per hit instead of a debug exception plus single-step, and has no
+// limit of four like Breakpoint.
+class MidHook : public MemoryOperation
+{
+public:
+    typedef void (*Callback)(PCONTEXT ctx);   // same signature as Breakpoint::Callback
+
+    MidHook(uintptr_t address, Callback callback);
+    ~MidHook();
+
+    bool   Apply()   override;
+    bool   Restore() override;
+    size_t GetLength() const override { return kJumpSize; }
+
+    bool IsApplied() const { return is_modified; }
+
+    static constexpr size_t kJumpSize = 5;
+    static constexpr size_t kMaxStubSize = 768;   // x64 stub is 682 bytes
+
+    typedef void (*DispatchFn)(void* user, PCONTEXT ctx);
+
+    // Writes the register-saving stub into out (which will run where it is written).
+    // The stub calls dispatch(user, ctx) with ctx->Rip/Eip = hookAddress and resumes at
+    // whatever ctx->Rip/Eip holds afterwards. Returns the stub size, 0 if capacity is too small.
+    // Does not depend on the host ABI (the arguments are passed in both rcx/rdx and rdi/rsi).
+    static size_t EmitStub(uint8_t* out, size_t capacity, uintptr_t hookAddress, DispatchFn dispatch, void* user);
+
+private:
+    static void Dispatch(void* self, PCONTEXT ctx);
+
+    Callback  callback = nullptr;
+    uint8_t*  trampoline = nullptr;
+    uint8_t   jump[kJumpSize]{};
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <Windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+
+// On-disk cache for per-module indexes (Symbolizer, SignatureIndex, XrefIndex).
+// Files are named <module>-<TimeDateStamp><SizeOfImage>.<ext>, so a rebuilt module never maps
+// a stale index, and live in %TEMP%\MemoryOperation\<subdirectory> unless SetDirectory was called.
+// Each index keeps one ModuleCache for its kind and reads the file through a read-only mapping.
+class ModuleCache
+{
+public:
+    // What a cache file is keyed on
+    struct Identity
+    {
+        std::string name;            // file name of the module
+        uint32_t    timeDateStamp = 0;
+        uint32_t    sizeOfImage = 0;
+    };
+
+    // Start of every cache file; the index's own fields follow it
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t timeDateStamp;
+        uint32_t sizeOfImage;
+    };
+
+    struct Chunk
+    {
+        const void* data;
+        size_t      size;
+    };
+
+    // A mapped cache file, unmapped on destruction
+    class Mapping
+    {
+    public:
+        Mapping() = default;
+        ~Mapping() { Close(); }
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        bool        IsOpen() const { return view != nullptr; }
+        const void* Data() const { return view; }
+        uint64_t    Size() const { return size; }
+        void        Close();
+
+    private:
+        friend class ModuleCache;
+        HANDLE      mapping = nullptr;
+        const void* view = nullptr;
+        uint64_t    size = 0;
+    };
+
+    ModuleCache(const char* subdirectory, const char* extension, uint32_t magic, uint32_t version);
+
+    // Null if base is not a PE image
+    static const IMAGE_NT_HEADERS* NtHeaders(uintptr_t base);
+    // False if base is not a PE image
+    static bool GetIdentity(uintptr_t base, Identity& out);
+
+    // "" disables the cache
+    void SetDirectory(const std::string& directory);
+    // Empty when the cache is disabled or %TEMP% is unavailable
+    std::string GetPath(const Identity& module) const;
+
+    Header MakeHeader(const Identity& module) const;
+
+    // Maps path if it starts with this cache's Header for module; the index checks the rest
+    bool Map(const std::string& path, const Identity& module, Mapping& out) const;
+    // Writes the chunks under a temporary name and renames it, so a reader never maps a partial file
+    bool Write(const std::string& path, std::initializer_list<Chunk> chunks) const;
+
+private:
+    const char* subdirectory;
+    const char* extension;
+    uint32_t    magic;
+    uint32_t    version;
+
+    mutable std::mutex mutex;
+    std::string        directory;
+    bool               directorySet = false;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <Windows.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Location of an operation inside a module that may not be mapped yet.
+// If pattern is set the signature is scanned for inside the module and offset
+// is added to the hit, otherwise offset is relative to the module base.
+struct ModuleTarget
+{
+    std::string module;
+    uintptr_t   offset = 0;
+    std::string pattern{};
+
+    uintptr_t Resolve(uintptr_t moduleBase) const;
+};
+
+// Forwards loader notifications (LdrRegisterDllNotification) to MemoryOperator.
+// The notification runs under the loader lock, so it only records (module, base);
+// a worker thread resolves and applies the pending operations once the lock is released.
+class ModuleWatcher
+{
+public:
+    static bool   Install();
+    // Stops and joins the worker. Must not be called under the loader lock (DllMain,
+    // DLL_PROCESS_DETACH, static destructors): the worker needs the lock to exit.
+    static void   Remove();
+    static bool   IsInstalled();
+
+    // Fallback for hosts where the notification is unavailable: resolve every
+    // pending module that is currently loaded. Returns the number of operations applied.
+    // Must not be called under the loader lock (e.g. from DllMain).
+    static size_t Poll();
+
+    // Hands an already-mapped module to the worker, as if its load had just been reported.
+    // False if no worker is running; the caller then resolves it itself.
+    static bool   Enqueue(const std::string& module, uintptr_t base);
+
+    static std::string NormalizeName(const std::string& module);
+
+private:
+    static PVOID  s_cookie;
+    static HANDLE s_worker;
+    static HANDLE s_wake;
+    static std::atomic<bool> s_stop;
+
+    // modules reported by the notification, not yet handed to MemoryOperator
+    static std::vector<std::pair<std::string, uintptr_t>> s_loaded;
+    static std::mutex s_loadedMutex;
+
+    static VOID CALLBACK LoaderNotification(ULONG reason, const void* data, PVOID context);
+    static DWORD WINAPI  WorkerThread(LPVOID);
+    static size_t        DrainLoaded();
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include "HookTemplate.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <variant>
+#include <type_traits>
+#include <vector>
+
+/**
+ * One detour per target, dispatching to an ordered list of callbacks.
+ *
+ *   using DamageChain = MultiHook<"Damage", int(__thiscall*)(Player*, int)>;
+ *   DamageChain::Install(address);
+ *   auto id = DamageChain::Add(
+ *       [](DamageChain::Context& c, void*) { c.Arg<1>() /= 2; },         // pre: edit arguments
+ *       [](DamageChain::Context& c, void*) { c.result = 0; });           // post: edit the result
+ *   DamageChain::Remove(id);
+ *
+ * Pre callbacks run by ascending priority, post callbacks in the reverse order.
+ * A pre callback may set skipOriginal (and result) to bypass the original function.
+ * The callback list is immutable once published: Add/Remove build a new list and swap the
+ * pointer, so dispatch takes no lock. Run counts the threads inside the hook; a replaced
+ * list is freed by the next Add/Remove that finds the count at zero, since no thread can
+ * still be iterating it then.
+ */
+template<typename R, typename... A>
+struct CallContext
+{
+    using Result = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+    std::tuple<A...> args;
+    Result           result{};
+    bool             skipOriginal = false;
+
+    template<size_t I>
+    auto& Arg() { return std::get<I>(args); }
+};
+
+namespace multihook_detail
+{
+    // Signature<Fn>::Entry<Owner> is a function with the same type as Fn that forwards to Owner::Run
+    template<typename Fn>
+    struct Signature
+    {
+        static_assert(sizeof(Fn) == 0, "MultiHook needs a function pointer type");
+    };
+
+    template<typename R, typename... A>
+    struct Signature<R(*)(A...)>
+    {
+        using Context = CallContext<R, A...>;
+        using Return  = R;
+        template<typename Owner> static R Entry(A... a) { return Owner::Run(Context{ { a... } }); }
+    };
+
+#ifndef _WIN64
+    template<typename R, typename... A>
+    struct Signature<R(__stdcall*)(A...)>
+    {
+        using Context = CallContext<R, A...>;
+        using Return  = R;
+        template<typename Owner> static R __stdcall Entry(A... a) { return Owner::Run(Context{ { a... } }); }
+    };
+
+    template<typename R, typename... A>
+    struct Signature<R(__fastcall*)(A...)>
+    {
+        using Context = CallContext<R, A...>;
+        using Return  = R;
+        template<typename Owner> static R __fastcall Entry(A... a) { return Owner::Run(Context{ { a... } }); }
+    };
+
+    // __thiscall can't be declared on a free function: take this in ecx via __fastcall, ignore edx
+    template<typename R, typename C, typename... A>
+    struct Signature<R(__thiscall*)(C*, A...)>
+    {
+        using Context = CallContext<R, C*, A...>;
+        using Return  = R;
+        template<typename Owner> static R __fastcall Entry(C* self, void*, A... a) { return Owner::Run(Context{ { self, a... } }); }
+    };
+#endif
+}
+
+template<FixedString Name, typename Fn>
+class MultiHook
+{
+public:
+    using Context = typename multihook_detail::Signature<Fn>::Context;
+    using Return  = typename multihook_detail::Signature<Fn>::Return;
+    typedef void (*Callback)(Context& context, void* user);
+
+    static inline Fn         Original = nullptr;
+    static inline WinDetour* Detour = nullptr;
+
+    static constexpr std::string_view GetName() { return Name.View(); }
+
+    // Installs the single detour for this target. Callbacks may be added before or after.
+    static bool Install(uintptr_t address)
+    {
+        if (!address) return false;
+        if (Detour && Detour->IsApplied()) return true;
+
+        Original = reinterpret_cast<Fn>(address);
+        Detour = MemoryOperator::CreateDetour(std::string(GetName()), reinterpret_cast<uintptr_t>(&Original),
+            reinterpret_cast<uintptr_t>(&multihook_detail::Signature<Fn>::template Entry<MultiHook>), true);
+        if (!Detour) return false;
+
+        if (MemoryOperator::InHookTransaction()) {
+            MemoryOperator::QueueHook(std::string(GetName()));
+            return true;
+        }
+        return Detour->Apply();
+    }
+
+    static bool Uninstall() { return !Detour || Detour->Restore(); }
+
+    // Returns an id for Remove(); pre or post may be null
+    static uint64_t Add(Callback pre, Callback post, void* user = nullptr, int priority = 0)
+    {
+        std::lock_guard lock(writeMutex);
+        auto list = Copy();
+        const uint64_t id = ++lastId;
+
+        auto at = std::ranges::upper_bound(list->entries, priority, {}, &Entry::priority);
+        list->entries.insert(at, Entry{ id, priority, pre, post, user });
+        Publish(std::move(list));
+        return id;
+    }
+
+    static bool Remove(uint64_t id)
+    {
+        std::lock_guard lock(writeMutex);
+        auto list = Copy();
+        if (!std::erase_if(list->entries, [id](const Entry& e) { return e.id == id; })) return false;
+        Publish(std::move(list));
+        return true;
+    }
+
+    static size_t GetCallbackCount()
+    {
+        const List* list = current.load(std::memory_order_acquire);
+        return list ? list->entries.size() : 0;
+    }
+
+    // Drops every callback and frees replaced lists. Only call while the hook is not installed
+    // or no thread can be inside it.
+    static void Clear()
+    {
+        std::lock_guard lock(writeMutex);
+        current.store(nullptr, std::memory_order_release);
+        live.reset();
+        graveyard.clear();
+    }
+
+    // Called by the entry stub with the arguments packed into a context
+    static Return Run(Context ctx)
+    {
+        // Counted before the list is loaded, so Publish sees either this caller or the new list
+        active.fetch_add(1);
+        struct Leave { ~Leave() { active.fetch_sub(1, std::memory_order_release); } } leave;
+        const List* list = current.load();
+        const size_t count = list ? list->entries.size() : 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            if (auto pre = list->entries[i].pre) pre(ctx, list->entries[i].user);
+        }
+
+        if (!ctx.skipOriginal) {
+            if constexpr (std::is_void_v<Return>) std::apply(Original, ctx.args);
+            else ctx.result = std::apply(Original, ctx.args);
+        }
+
+        for (size_t i = count; i-- > 0;) {
+            if (auto post = list->entries[i].post) post(ctx, list->entries[i].user);
+        }
+
+        if constexpr (!std::is_void_v<Return>) return ctx.result;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t id;
+        int      priority;
+        Callback pre;
+        Callback post;
+        void*    user;
+    };
+
+    struct List
+    {
+        std::vector<Entry> entries;
+    };
+
+    static std::unique_ptr<List> Copy()
+    {
+        const List* list = current.load(std::memory_order_relaxed);
+        return list ? std::make_unique<List>(*list) : std::make_unique<List>();
+    }
+
+    static void Publish(std::unique_ptr<List> list)
+    {
+        current.store(list.get());
+        if (live) graveyard.push_back(std::move(live));
+        live = std::move(list);
+
+        // No thread inside the hook: none can hold a replaced list any more
+        if (active.load() == 0) graveyard.clear();
+    }
+
+    static inline std::atomic<const List*>          current{ nullptr };
+    static inline std::unique_ptr<List>              live;        // owns current
+    static inline std::vector<std::unique_ptr<List>> graveyard;   // replaced lists a caller may still iterate
+    static inline std::atomic<uint32_t>              active{ 0 }; // threads inside Run
+    static inline std::mutex                         writeMutex;
+    static inline uint64_t                           lastId = 0;
+};
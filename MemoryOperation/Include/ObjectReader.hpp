@@ -0,0 +1,227 @@
+#pragma once
+#include "FixedString.h"
+#include "Memory.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Declarative object layouts read with one guarded copy per object.
+ *
+ *   using Weapon = Layout<0x80, Field<"ammo", int32_t, 0x24>>;
+ *   using Player = Layout<0x400,
+ *       Field<"health", float, 0x100>,
+ *       Field<"position", Vec3, 0x30>,
+ *       Field<"weapon", Ptr<Weapon>, 0x48>>;
+ *
+ *   std::vector<Player::View> players;
+ *   Player::ReadPointers(entityList, count, players);      // 1 copy for the list, 1 per player
+ *   std::vector<Weapon::View> weapons;
+ *   Player::ReadChildren<"weapon">(players, weapons);      // prefetched, 1 copy per weapon
+ *   float hp = players[0].Get<"health">();
+ *
+ * Offsets default to the declared ones and can be replaced at runtime, e.g. after a signature
+ * resolved a moved field: Player::SetOffset<"health">(0x108). Change offsets between reads,
+ * not while another thread is reading the same layout.
+ */
+template<typename ChildLayout>
+struct Ptr
+{
+    using Layout = ChildLayout;
+};
+
+template<FixedString Name, typename T, uint32_t Offset>
+struct Field
+{
+    static constexpr auto     name = Name;
+    static constexpr uint32_t offset = Offset;
+    using Type = T;
+};
+
+namespace object_detail
+{
+    // What a field holds in memory: a Ptr<> is just an address
+    template<typename T>
+    struct Storage { using Type = T; static constexpr bool isPointer = false; };
+
+    template<typename L>
+    struct Storage<Ptr<L>> { using Type = uintptr_t; static constexpr bool isPointer = true; using Child = L; };
+
+    // Hint the cache lines of the next level in before copying them one by one; a prefetch
+    // of an unmapped address is dropped by the CPU, it does not fault
+    inline void Prefetch(const std::vector<uintptr_t>& addresses, size_t span)
+    {
+        for (uintptr_t address : addresses) {
+            if (!address) continue;
+            for (size_t line = 0; line < span; line += 64) {
+                _mm_prefetch(reinterpret_cast<const char*>(address + line), _MM_HINT_T0);
+            }
+        }
+    }
+}
+
+template<size_t Size, typename... Fields>
+class Layout
+{
+public:
+    static constexpr size_t kSize = Size;
+    static constexpr size_t kFieldCount = sizeof...(Fields);
+
+    static_assert(((Fields::offset + sizeof(typename object_detail::Storage<typename Fields::Type>::Type) <= Size) && ...),
+        "Field does not fit in the declared object size");
+    static_assert((std::is_trivially_copyable_v<typename object_detail::Storage<typename Fields::Type>::Type> && ...),
+        "Field types must be trivially copyable");
+
+    template<FixedString Name>
+    static constexpr size_t IndexOf()
+    {
+        constexpr size_t index = Find(Name.View());
+        static_assert(index < kFieldCount, "Layout has no field with this name");
+        return index;
+    }
+
+    template<FixedString Name>
+    using FieldOf = std::tuple_element_t<IndexOf<Name>(), std::tuple<Fields...>>;
+
+    template<FixedString Name>
+    using TypeOf = typename object_detail::Storage<typename FieldOf<Name>::Type>::Type;
+
+    template<FixedString Name>
+    static uint32_t GetOffset() { return offsets[IndexOf<Name>()]; }
+
+    // False (and unchanged) if the field would not fit in kSize
+    template<FixedString Name>
+    static bool SetOffset(uint32_t offset)
+    {
+        if (offset + sizeof(TypeOf<Name>) > Size) return false;
+        offsets[IndexOf<Name>()] = offset;
+        span = ComputeSpan();
+        return true;
+    }
+
+    static void ResetOffsets()
+    {
+        offsets = { Fields::offset... };
+        span = ComputeSpan();
+    }
+
+    // Bytes copied per object: up to the end of the furthest field, not necessarily kSize
+    static size_t GetSpan() { return span; }
+
+    class View
+    {
+    public:
+        bool      Valid() const { return address != 0; }
+        uintptr_t Address() const { return address; }
+
+        template<FixedString Name>
+        TypeOf<Name> Get() const
+        {
+            TypeOf<Name> value;
+            memcpy(&value, data.data() + offsets[IndexOf<Name>()], sizeof(value));
+            return value;
+        }
+
+    private:
+        friend class Layout;
+        uintptr_t                  address = 0;
+        std::array<uint8_t, Size>  data{};
+    };
+
+    // One guarded copy of the object at address
+    static bool Read(uintptr_t address, View& out)
+    {
+        out.address = 0;
+        if (!address || !Memory::ReadRaw(address, out.data.data(), span)) return false;
+        out.address = address;
+        return true;
+    }
+
+    // count objects stored inline every stride bytes: one copy for the whole array, falling
+    // back to one copy per object if part of it is unreadable. Returns the valid views.
+    static size_t ReadArray(uintptr_t address, size_t count, std::vector<View>& out, size_t stride = Size)
+    {
+        out.assign(count, View{});
+        if (!address || !count || stride < span) return 0;
+
+        std::vector<uint8_t> block((count - 1) * stride + span);
+        if (!Memory::ReadRaw(address, block.data(), block.size())) {
+            size_t valid = 0;
+            for (size_t i = 0; i < count; i++) valid += Read(address + i * stride, out[i]);
+            return valid;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            memcpy(out[i].data.data(), block.data() + i * stride, span);
+            out[i].address = address + i * stride;
+        }
+        return count;
+    }
+
+    // count object pointers stored at address (an entity list): one copy for the list, then one
+    // per non-null object after prefetching them all. out[i] is invalid for a null/unreadable entry.
+    static size_t ReadPointers(uintptr_t address, size_t count, std::vector<View>& out)
+    {
+        std::vector<uintptr_t> pointers(count);
+        if (!count || !Memory::ReadRaw(address, pointers.data(), count * sizeof(uintptr_t))) {
+            out.assign(count, View{});
+            return 0;
+        }
+        return ReadAll(pointers, out);
+    }
+
+    // Follows the Ptr<> field Name of every parent into children[i] (invalid where the parent
+    // is invalid or the pointer is null/unreadable)
+    template<FixedString Name, typename ChildView>
+    static size_t ReadChildren(const std::vector<View>& parents, std::vector<ChildView>& children)
+    {
+        using Storage = object_detail::Storage<typename FieldOf<Name>::Type>;
+        static_assert(Storage::isPointer, "ReadChildren needs a Ptr<> field");
+        static_assert(std::is_same_v<ChildView, typename Storage::Child::View>, "Wrong child view type");
+
+        std::vector<uintptr_t> pointers(parents.size(), 0);
+        for (size_t i = 0; i < parents.size(); i++) {
+            if (parents[i].Valid()) pointers[i] = parents[i].template Get<Name>();
+        }
+        return Storage::Child::ReadAll(pointers, children);
+    }
+
+    // Objects at the given addresses (0 = skip), prefetched as one batch
+    static size_t ReadAll(const std::vector<uintptr_t>& addresses, std::vector<View>& out)
+    {
+        out.assign(addresses.size(), View{});
+        object_detail::Prefetch(addresses, span);
+
+        size_t valid = 0;
+        for (size_t i = 0; i < addresses.size(); i++) {
+            valid += Read(addresses[i], out[i]);
+        }
+        return valid;
+    }
+
+private:
+    static constexpr size_t Find(std::string_view name)
+    {
+        constexpr std::array<std::string_view, kFieldCount> names{ Fields::name.View()... };
+        for (size_t i = 0; i < kFieldCount; i++) {
+            if (names[i] == name) return i;
+        }
+        return kFieldCount;
+    }
+
+    static constexpr size_t ComputeSpan(const std::array<uint32_t, kFieldCount>& at)
+    {
+        size_t end = 0;
+        size_t i = 0;
+        ((end = (std::max)(end, size_t(at[i++]) + sizeof(typename object_detail::Storage<typename Fields::Type>::Type))), ...);
+        return end ? end : 1;
+    }
+    static size_t ComputeSpan() { return ComputeSpan(offsets); }
+
+    static inline std::array<uint32_t, kFieldCount> offsets{ Fields::offset... };
+    static inline size_t span = ComputeSpan({ Fields::offset... });
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Minimal fork-join helper for the offline index builders (signatures, pointer maps, xrefs).
+// Work items are handed out through a shared counter, so uneven items (one huge section,
+// many small ones) still keep every worker busy. Not for hot paths: threads are created per call.
+class Parallel
+{
+public:
+    static unsigned WorkerCount()
+    {
+        const unsigned hardware = std::thread::hardware_concurrency();
+        return hardware ? hardware : 4;
+    }
+
+    // Calls fn(i) for every i in [0, count), from up to WorkerCount() threads including the caller
+    template<typename Fn>
+    static void For(size_t count, Fn&& fn)
+    {
+        if (!count) return;
+
+        std::atomic<size_t> next{ 0 };
+        auto worker = [&]() {
+            for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed)) {
+                fn(i);
+            }
+        };
+
+        const size_t extra = (std::min)(static_cast<size_t>(WorkerCount()), count) - 1;
+        std::vector<std::thread> threads;
+        threads.reserve(extra);
+        for (size_t t = 0; t < extra; ++t) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Sorts slices in parallel, then merges neighbours pairwise until one run is left
+    template<typename T, typename Less>
+    static void Sort(std::vector<T>& items, Less less)
+    {
+        const size_t slices = (std::min)(static_cast<size_t>(WorkerCount()), (std::max)(items.size(), size_t(1)));
+        std::vector<size_t> bounds(slices + 1);
+        for (size_t s = 0; s <= slices; s++) bounds[s] = items.size() * s / slices;
+
+        For(slices, [&](size_t s) {
+            std::sort(items.begin() + bounds[s], items.begin() + bounds[s + 1], less);
+        });
+        for (size_t width = 1; width < slices; width *= 2) {
+            For((slices + 2 * width - 1) / (2 * width), [&](size_t pair) {
+                const size_t left = pair * 2 * width;
+                const size_t middle = (std::min)(left + width, slices);
+                const size_t right = (std::min)(left + 2 * width, slices);
+                if (middle < right) {
+                    std::inplace_merge(items.begin() + bounds[left], items.begin() + bounds[middle], items.begin() + bounds[right], less);
+                }
+            });
+        }
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "MemoryOperation.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Named groups of MemoryOperator operations, combined into profiles.
+// Switching profiles only touches the operations whose state differs between the two:
+// the diff for a pair of profiles is computed once and cached until the registry changes.
+class PatchProfiles
+{
+public:
+    static bool DefineGroup(const std::string& group, const std::vector<std::string>& operations);
+    static bool DefineProfile(const std::string& profile, const std::vector<std::string>& groups);
+
+    // Restores what the active profile has and the target lacks, then applies the rest.
+    // If any step fails every step already taken is undone and false is returned.
+    static bool SwitchTo(const std::string& profile);
+
+    // Switch back to the profile that was active before the last successful SwitchTo.
+    static bool Rollback();
+
+    // Leave the active profile: restores everything it applied.
+    static bool Deactivate() { return SwitchTo(""); }
+
+    static const std::string& GetActiveProfile() { return activeProfile; }
+    static void Clear();
+
+private:
+    using OperationList = std::vector<std::shared_ptr<MemoryOperation>>;
+
+    struct Profile
+    {
+        std::vector<std::string> groups;
+        OperationList            resolved{};   // sorted by pointer, unique
+        uint64_t                 revision = ~0ull;
+    };
+
+    struct Transition
+    {
+        OperationList toRestore;
+        OperationList toApply;
+        uint64_t      revision = ~0ull;
+    };
+
+    static const OperationList* Resolve(const std::string& profile);
+    static const Transition*    GetTransition(const std::string& from, const std::string& to);
+    static bool                 Commit(const Transition& transition);
+
+    static std::map<std::string, std::vector<std::string>> groups;
+    static std::map<std::string, Profile> profiles;
+    static std::map<std::pair<std::string, std::string>, Transition> transitions;
+    static std::string activeProfile;
+    static std::string previousProfile;
+};
@@ -7,7 +7,8 @@
 class Scanner
 {
 public:
-	Scanner(uintptr_t Address, const std::string& pattern);
+	// EndAddress bounds Scan(results) (e.g. base + module size); 0 scans to the top of user space
+	Scanner(uintptr_t Address, const std::string& pattern, uintptr_t EndAddress = 0);
 	~Scanner();
 	bool Scan(uintptr_t* results);
 	bool Scan(uintptr_t* results, bool scanForFunction);
@@ -16,6 +17,7 @@ private:
 	std::vector<uint8_t> pattern;
 	std::vector<bool> mask;
 	uintptr_t startAddress;
+	uintptr_t endAddress;
 	bool ParsePattern(const std::string& pattern);
 
 };
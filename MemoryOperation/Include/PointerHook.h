@@ -0,0 +1,35 @@
+#pragma once
+#include "MemoryOperation.h"
+
+// Base for hooks that redirect a function pointer slot (IAT entry, vtable slot, vptr).
+// Apply/Restore are a single interlocked compare-exchange on the slot: no code is
+// rewritten, no thread is suspended and no i-cache flush is needed.
+// Restore only puts the original back if the slot still holds our replacement, so a
+// hook layered on top of ours by someone else is not silently dropped.
+class PointerHook : public MemoryOperation
+{
+public:
+    ~PointerHook();
+
+    bool   Apply()   override;
+    bool   Restore() override;
+    size_t GetLength() const override { return sizeof(uintptr_t); }
+
+    bool IsApplied() const { return is_modified; }
+
+    uintptr_t GetOriginal() const { return originalValue; }
+
+    template<typename T>
+    T GetOriginal() const { return reinterpret_cast<T>(originalValue); }
+
+protected:
+    PointerHook() = default;
+
+    // slot: address of the pointer to swap; value: what to store there while applied
+    void Init(uintptr_t slot, uintptr_t value);
+
+    static bool Swap(uintptr_t slot, uintptr_t expected, uintptr_t desired);
+
+    uintptr_t replacementValue = 0;
+    uintptr_t originalValue = 0;
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Finds static pointer chains (module+rva -> +off -> +off ... -> target).
+// Build() snapshots readable memory and keeps every aligned pointer-sized value that points into
+// it, as (value, location) pairs sorted by value; regions are swept in parallel chunks, and the
+// scanner's own working memory is left out. Scan() then walks backward from the target one level
+// at a time: entries whose value lies within maxOffset below an address of the previous level are
+// its links, each location is expanded once per level, and a link inside a module image ends a path.
+// Results from Scan() can be saved, and after a restart Validate() keeps only the paths that still
+// lead to the (new) target address, which narrows a large set down in a few runs.
+class PointerScanner
+{
+public:
+    static constexpr size_t kMaxDepth = 7;
+
+    // Memory to index. data == nullptr reads the range from this process (guarded against
+    // concurrent frees); a non-null data lets a synthetic heap stand in for the process.
+    struct Region
+    {
+        uintptr_t      base = 0;
+        size_t         size = 0;
+        const uint8_t* data = nullptr;
+        int            module = -1;   // index into the module list if the range is part of a module image
+    };
+
+    struct Module
+    {
+        std::string name;
+        uintptr_t   base = 0;
+    };
+
+    // [[module+rva] + offsets[0]] + offsets[1] ... + offsets[depth-1] == target
+    struct Path
+    {
+        uint16_t module = 0;
+        uint8_t  depth = 0;
+        uint32_t rva = 0;
+        int32_t  offsets[kMaxDepth] = {};
+    };
+
+    // Paths refer to modules by index so a result set stays small and survives rebasing
+    struct PathSet
+    {
+        std::vector<std::string> modules;
+        std::vector<Path>        paths;
+    };
+
+    struct Options
+    {
+        size_t maxDepth = 5;          // links per path, at most kMaxDepth
+        size_t maxOffset = 0x1000;    // largest offset added after a dereference
+        size_t maxResults = 1000000;
+    };
+
+    // Snapshot of this process: committed, readable, non-guard memory, module images marked
+    bool Build();
+    // Index the given ranges instead (regions may be in any order)
+    bool Build(const std::vector<Module>& modules, const std::vector<Region>& regions);
+
+    size_t GetPointerCount() const { return entries.size(); }
+
+    PathSet Scan(uintptr_t target, const Options& options) const;
+    PathSet Scan(uintptr_t target) const { return Scan(target, Options{}); }
+
+    // Follows a path in this process; false if a link is unreadable or the module is not loaded
+    static bool Resolve(const PathSet& set, const Path& path, uintptr_t& out);
+
+    // Drops the paths that no longer resolve to target; returns how many are left
+    static size_t Validate(PathSet& set, uintptr_t target);
+
+    static bool Save(const PathSet& set, const std::string& path);
+    static bool Load(const std::string& path, PathSet& set);
+
+    // "game.exe+0x1A2B30 -> 0x10 -> 0x218"
+    static std::string Format(const PathSet& set, const Path& path);
+
+private:
+    struct Entry
+    {
+        uintptr_t value;
+        uintptr_t location;
+    };
+
+    std::vector<Module> modules;
+    std::vector<Region> regions;   // sorted by base
+    std::vector<Entry>  entries;   // sorted by value
+
+    const Region* FindRegion(uintptr_t address) const;
+    void ReleaseEntries();
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include <Windows.h>
+#include <vector>
+
+// Snapshot of the threads of the current process.
+class ProcessThreads
+{
+public:
+    // Thread ids of every thread in this process except the caller
+    static std::vector<DWORD>  EnumerateOthers();
+
+    // Opens every other thread with the requested access; threads that cannot be
+    // opened (already exiting, protected) are skipped. Close with CloseAll().
+    static std::vector<HANDLE> OpenOthers(DWORD access);
+    static void                CloseAll(std::vector<HANDLE>& handles);
+};
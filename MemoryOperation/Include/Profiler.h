@@ -0,0 +1,36 @@
+#pragma once
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+
+// In-process sampling profiler.
+// A sampler thread wakes every interval, and for each other thread: suspends it, reads its
+// context and copies the top of its stack, resumes it, then unwinds the copy with
+// Traceback::WalkCopy. Nothing that can take a lock runs while a thread is suspended.
+// Stacks are merged into a call tree keyed by (parent node, return address) in an open-addressing
+// table, so memory grows with the number of distinct paths, not with the number of samples.
+class Profiler
+{
+public:
+    static constexpr USHORT kMaxDepth = 64;
+    static constexpr size_t kStackCopy = 16 * 1024;       // bytes of each stack copied per sample
+    static constexpr DWORD  kThreadRefreshMs = 250;       // how often the thread list is re-enumerated
+
+    static bool     Start(DWORD intervalMicroseconds = 1000);
+    static void     Stop();
+    static bool     IsRunning();
+    static void     Reset();
+
+    static uint64_t GetSampleCount();
+    static uint64_t GetTicks();          // sampler wake-ups, each sampling every thread once
+
+    // One line per distinct stack, outermost frame first: "a.dll!F;b.exe!G 12"
+    // (flamegraph.pl / speedscope input)
+    static bool     WriteFolded(const std::string& path);
+
+    // Uncompressed profile.proto, readable by `go tool pprof` and most pprof viewers
+    static bool     WritePprof(const std::string& path);
+
+private:
+    static DWORD WINAPI SamplerThread(LPVOID);
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include "ModuleCache.h"
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Suffix array over the executable sections of one module, for counting and generating
+// byte signatures without rescanning the image.
+// Suffixes are ordered by their first kMaxDepth bytes only: that bounds the cost of sorting long
+// repeats (int3/nop padding) and is all a signature needs. Construction buckets suffixes by their
+// first two bytes and sorts the buckets in parallel; the text and the array are then saved as a
+// cache file keyed by the module's TimeDateStamp/SizeOfImage, like Symbolizer's index.
+class SignatureIndex
+{
+public:
+    static constexpr size_t kMaxDepth = 64;
+
+    // Same text format as Scanner: "48 8B 05 ?? ?? ?? ?? 48 85 C0"
+    struct Pattern
+    {
+        std::vector<uint8_t> bytes;
+        std::vector<bool>    mask;   // false = wildcard
+
+        static bool Parse(const std::string& text, Pattern& out);
+        std::string ToString() const;
+    };
+
+    // Snapshot of moduleBase (the main module if 0). Throws std::invalid_argument if it is not a
+    // PE image with executable sections.
+    explicit SignatureIndex(uintptr_t moduleBase = 0);
+    SignatureIndex(const SignatureIndex&) = delete;
+    SignatureIndex& operator=(const SignatureIndex&) = delete;
+
+    // Matches of the pattern, counting stops at limit. O(k log n) for the most selective solid run
+    // of k bytes, plus a check of each of its occurrences when the pattern has wildcards.
+    size_t Count(const Pattern& pattern, size_t limit = SIZE_MAX) const;
+    size_t Count(const std::string& pattern, size_t limit = SIZE_MAX) const;
+
+    // Addresses of up to max matches, ascending
+    std::vector<uintptr_t> Find(const Pattern& pattern, size_t max = SIZE_MAX) const;
+
+    // Shortest pattern starting at address that matches exactly once, with rip-relative and
+    // branch displacements, 32/64-bit immediates and base-relocated bytes wildcarded.
+    // Empty if address is outside the indexed code or nothing up to maxLength is unique.
+    std::string Generate(uintptr_t address, size_t maxLength = kMaxDepth) const;
+
+    uintptr_t GetModuleBase() const { return moduleBase; }
+    size_t    GetTextSize() const { return size; }
+    bool      IsFromCache() const { return cache.IsOpen(); }
+
+    // Cache files go to %TEMP%\MemoryOperation\signatures unless set; "" disables the cache
+    static void SetCacheDirectory(const std::string& directory);
+
+private:
+    struct Section
+    {
+        uint32_t rva;
+        uint32_t size;
+        uint32_t offset;   // position of the section in the text
+    };
+
+    struct Range
+    {
+        size_t first;
+        size_t last;       // one past
+    };
+
+    uintptr_t             moduleBase = 0;
+    ModuleCache::Identity module;
+
+    std::vector<Section>  sections;
+    std::vector<uint32_t> relocations;   // rvas of base-relocated bytes, sorted
+
+    const uint8_t*  text = nullptr;
+    const uint32_t* suffixes = nullptr;
+    size_t          size = 0;
+
+    // backing storage: the mapped cache file, or what was built in memory
+    ModuleCache::Mapping  cache;
+    std::vector<uint8_t>  builtText;
+    std::vector<uint32_t> builtSuffixes;
+
+    void ReadImage();
+    void Build();
+    bool MapCache(const std::string& path);
+    void WriteCache(const std::string& path) const;
+
+    Range Search(const uint8_t* key, size_t length) const;
+    bool Matches(size_t position, const Pattern& pattern) const;
+    size_t Scan(const Pattern& pattern, size_t limit, std::vector<uintptr_t>* out) const;
+    bool IsRelocated(uint32_t rva) const;
+
+    uintptr_t ToAddress(size_t position) const;
+    bool ToPosition(uintptr_t address, size_t& position) const;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <windows.h>
+#include "AddressMap.h"
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// int3 breakpoints: same callback model as Breakpoint, without its limit of four.
+// The first instruction at each address is relocated into a small trampoline when the
+// breakpoint is set; after the callback the thread continues there, so the int3 never has to
+// be lifted and other threads keep hitting it. Instructions the relocator cannot move fall
+// back to restoring the byte, single-stepping and re-arming, with the pending re-arm kept per
+// thread (other threads can pass unnoticed during that one step).
+// Dispatch is one AddressMap probe, however many breakpoints are set.
+class SoftBreakpoint {
+public:
+    typedef void (*Callback)(PCONTEXT ctx);   // same signature as Breakpoint::Callback
+
+    static bool   Set(uintptr_t address, Callback callback);
+    static bool   Remove(uintptr_t address);
+    static void   RemoveAll();
+
+    // All int3 bytes are written in one CodePatcher::WriteBatch pass (one protection change
+    // per page). Addresses already set, unreadable or holding an int3 are skipped.
+    // Returns the number set / removed.
+    static size_t SetBatch(const std::vector<std::pair<uintptr_t, Callback>>& points);
+    static size_t RemoveBatch(const std::vector<uintptr_t>& addresses);
+
+    static bool   IsSet(uintptr_t address);
+    static size_t GetCount();
+
+    static constexpr uint8_t kInt3 = 0xCC;
+    static constexpr size_t  kTrampolineSize = 64;   // one relocated instruction plus the jump back
+
+private:
+    struct Point {
+        Callback callback = nullptr;
+        uint8_t  original = 0;
+        uint8_t* trampoline = nullptr;   // null: single-step fallback
+    };
+    typedef AddressMap<Point> Table;
+
+    // Immutable once published; replaced tables are retired, not freed, since a handler on
+    // another core may still be probing them
+    static std::atomic<const Table*> s_table;
+    static const Table& Current();
+    static void Publish(const Table& next);
+
+    static void InstallHandler();
+    static uint8_t* Relocate(uintptr_t address);
+    static bool TryRearm(uintptr_t address);
+    static LONG WINAPI ExceptionHandler(PEXCEPTION_POINTERS ex);
+
+    static PVOID s_vehHandle;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+
+// Address -> module + nearest function.
+// Each module gets a sorted index of function starts, built on first use from its export
+// table (names) and, on x64, its .pdata function table (unnamed starts, so an address in a
+// non-exported function is not blamed on the export before it). The index is saved as a
+// cache file named after the module and its PE TimeDateStamp/SizeOfImage, and later runs map
+// that file instead of rebuilding it.
+class Symbolizer
+{
+public:
+    struct Symbol
+    {
+        uintptr_t   address = 0;
+        const char* module = nullptr;   // file name, nullptr outside any loaded module
+        uintptr_t   moduleBase = 0;
+        const char* name = nullptr;     // export name, nullptr if the function is not exported
+        uintptr_t   function = 0;       // start of the containing function, 0 if unknown
+    };
+
+    // module and name stay valid until Refresh()
+    static bool Resolve(uintptr_t address, Symbol& out);
+
+    // Resolves addresses[0..count) into out[0..count) with one sort and a single merge pass
+    // over modules and their indexes, instead of a lookup per address
+    static void ResolveBatch(const uintptr_t* addresses, size_t count, Symbol* out);
+
+    // "module!Name+0x12", "module!sub_1A2B0+0x12", "module+0x1A2C2" or "0x7FF6..."
+    static std::string Format(const Symbol& symbol);
+
+    // Cache files go to %TEMP%\MemoryOperation\symbols unless set; "" disables the cache
+    static void SetCacheDirectory(const std::string& directory);
+
+    // Drops the module list and indexes, e.g. after modules were unloaded
+    static void Refresh();
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Dispatch stub for soft-toggled hooks:
+//
+//     cmp byte ptr [flag], 0
+//     je  disabled
+//     jmp qword ptr [detour]
+//   disabled:
+//     jmp qword ptr [trampoline]
+//
+// The hook stays installed and points at the stub; enabling or disabling it is one release
+// store to the flag, and a disabled hook costs a predicted branch. The flag sits alone on its
+// own cache line: a store to a line that also holds code would flush the pipeline of every
+// thread executing it. Only flags are clobbered, which are dead at a function entry.
+class ToggleStub
+{
+public:
+    static constexpr size_t kLine = 64;
+    static constexpr size_t kSize = 2 * kLine;   // flag line + code line
+
+    // Carves a stub out of executable memory within rel32 reach of nearAddress (any on x86)
+    static uint8_t* Allocate(uintptr_t nearAddress);
+
+    // stub must be kLine aligned and kSize bytes, executing where it is written
+    static bool Emit(uint8_t* stub, uintptr_t detour, uintptr_t trampoline, bool enabled);
+
+    static uintptr_t Entry(const uint8_t* stub) { return reinterpret_cast<uintptr_t>(stub) + kLine; }
+
+    static void SetEnabled(uint8_t* stub, bool enabled);
+    static bool IsEnabled(const uint8_t* stub);
+
+    // For backends that only learn the trampoline after installing (Detours)
+    static void SetTrampoline(uint8_t* stub, uintptr_t trampoline);
+
+private:
+    static constexpr size_t kDetourSlot = kLine + 48;
+    static constexpr size_t kTrampolineSlot = kLine + 56;
+};
@@ -1,31 +1,35 @@
 #pragma once
 #include "Windows.h"
+#include "Symbolizer.h"
 #include <cstdint>
 #include <stdio.h>
 #include <array>
-#include <vector>
-
-
-#pragma once
-#include "Windows.h"
-#include <cstdint>
-#include <stdio.h>
-#include <array>
-#include <vector>
 #include <iostream>
 
 
+// Call stack capture by unwinding, not by scanning the stack for things that look like
+// return addresses. x64 uses the module unwind tables (RtlVirtualUnwind), x86 walks the EBP
+// frame chain. Walk() writes into the caller's array and does no I/O and no heap allocation.
 class Traceback {
 public:
+    static constexpr USHORT kMaxFrames = 62;
+
     struct FrameInfo {
         uintptr_t CallAddress{};
         USHORT    StackIndex{};
         void Dump() const
+        {
+            Symbolizer::Symbol symbol;
+            Symbolizer::Resolve(CallAddress, symbol);
+            Print(symbol);
+        }
+
+        void Print(const Symbolizer::Symbol& symbol) const
         {
             char msg[1024];
             _snprintf_s(msg, sizeof(msg), _TRUNCATE,
-                "[FrameInfo] %-2u) - " "0x%08x",
-                StackIndex, CallAddress);
+                "[FrameInfo] %-2u) - " "0x%p %s",
+                StackIndex, reinterpret_cast<void*>(CallAddress), Symbolizer::Format(symbol).c_str());
 
             std::cout << msg << std::endl;
         }
@@ -34,78 +38,42 @@ public:
 
     struct TraceInfo {
         USHORT StackSize{};
-        std::array<void*, 62> Stack{};
-        std::vector<FrameInfo> Frames{};
+        std::array<void*, kMaxFrames> Stack{};
+
+        FrameInfo Frame(USHORT index) const {
+            return FrameInfo{ reinterpret_cast<uintptr_t>(Stack[index]), index };
+        }
+        // Symbolizes the whole stack in one batch
         void Dump() const {
-            for (FrameInfo frame : Frames) {
-                frame.Dump();
+            std::array<Symbolizer::Symbol, kMaxFrames> symbols{};
+            Symbolizer::ResolveBatch(reinterpret_cast<const uintptr_t*>(Stack.data()), StackSize, symbols.data());
+            for (USHORT i = 0; i < StackSize; ++i) {
+                Frame(i).Print(symbols[i]);
             }
         }
     };
 
-
-    static USHORT ScanStackMemory(USHORT skip, USHORT maxFrames, void** addresses) {
-        USHORT count = 0;
-        DWORD* stackPtr;
-
-        __asm mov stackPtr, esp;
-
-        std::cout << "Starting stack scan from ESP: 0x" << stackPtr << std::endl;
-
-        DWORD* scanStart = stackPtr;
-        DWORD* scanEnd = stackPtr + 1024; // Scan up to 4KB of stack
-
-        std::cout << "Scanning from 0x" << scanStart << " to 0x" << scanEnd << std::endl;
-
-        for (DWORD* ptr = scanStart; ptr < scanEnd && count < maxFrames; ptr++) {
-            if (IsBadReadPtr(ptr, 4)) {
-                std::cout << "Bad read at 0x" << ptr << ", stopping scan" << std::endl;
-                break;
-            }
-
-            if (DWORD addr = *ptr; addr >= 0x00400000 && addr <= 0x7FFFFFFF) {
-                if (!IsBadReadPtr(reinterpret_cast<void*>(addr), 1)) {
-                    if (addr > 1 && !IsBadReadPtr(reinterpret_cast<void*>(addr - 1), 1)) {
-                        if (auto codePtr = reinterpret_cast<BYTE*>(addr - 1); *codePtr == 0xE8 || *codePtr == 0xFF || *codePtr == 0x9A) {
-                            std::cout << "Found potential return address at stack offset " << ((ptr - stackPtr) * 4)
-                                << ": 0x" << reinterpret_cast<void*>(addr) << std::endl;
-
-                            if (skip > 0) {
-                                skip--;
-                                std::cout << "Skipping this address (remaining skip: " << skip << ")" << std::endl;
-                            }
-                            else {
-                                addresses[count++] = reinterpret_cast<void*>(addr);
-                                std::cout << "Added address " << (count - 1) << ": 0x" << reinterpret_cast<void*>(addr) << std::endl;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        std::cout << "Stack memory scan found " << count << " addresses" << std::endl;
-        return count;
-    }
-
-    static TraceInfo Capture(const USHORT skip = 1, USHORT maxFrames = 62) {
-        if (maxFrames > 62) maxFrames = 62;
-
-        auto traceback = TraceInfo{};
-
-        traceback.StackSize = ScanStackMemory(skip, maxFrames, traceback.Stack.data());
-
-        traceback.Frames.reserve(traceback.StackSize);
-        std::cout << "Final stacktrace size: " << traceback.StackSize << std::endl;
-
-        for (USHORT i = 0; i < traceback.StackSize; ++i) {
-            std::cout << "Frame " << i << ": 0x" << traceback.Stack[i] << std::endl;
-            traceback.Frames.push_back(FrameInfo{
-                reinterpret_cast<uintptr_t>(traceback.Stack[i]),
-                i
-                });
-        }
-
-        return traceback;
-    }
-};
\ No newline at end of file
+    // Return addresses of the calling thread, innermost first; frame 0 is the caller of Walk.
+    // Returns the number of entries written to addresses.
+    static USHORT Walk(void** addresses, USHORT maxFrames, USHORT skip = 0);
+
+    // Same, starting at a captured context (exception record, suspended thread).
+    // Frame 0 is the context's own instruction pointer. ctx is not modified.
+    static USHORT Walk(const CONTEXT& ctx, void** addresses, USHORT maxFrames, USHORT skip = 0);
+
+    // Walk(ctx) for a thread that has been resumed since: stackCopy holds the size bytes that
+    // were at ctx's stack pointer while it was suspended. Nothing is read from the live stack,
+    // so the unwinder never runs while another thread is held suspended. Reads may go a little
+    // past size (large frames); keep zeroed slack after the copy, a zero return address ends the walk.
+    static USHORT WalkCopy(const CONTEXT& ctx, const void* stackCopy, size_t size,
+        void** addresses, USHORT maxFrames);
+
+    // Walk() into a TraceInfo; the default skip drops Capture's own frame
+    static TraceInfo Capture(const USHORT skip = 1, USHORT maxFrames = kMaxFrames);
+
+private:
+    static USHORT Unwind(CONTEXT& ctx, uintptr_t stackLow, uintptr_t stackHigh, intptr_t delta,
+        void** addresses, USHORT maxFrames, USHORT skip);
+    static void   Rebase(CONTEXT& ctx, uintptr_t stackLow, uintptr_t stackHigh, intptr_t delta);
+    static void StackBounds(uintptr_t sp, uintptr_t& low, uintptr_t& high);
+};
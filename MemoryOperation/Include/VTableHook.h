@@ -0,0 +1,45 @@
+#pragma once
+#include "PointerHook.h"
+#include <map>
+#include <memory>
+
+// Redirects one slot of a vtable: every object of that class (and of classes sharing
+// the vtable) calls the replacement.
+class VTableHook : public PointerHook
+{
+public:
+    VTableHook(uintptr_t vtable, size_t index, uintptr_t replacement);
+};
+
+// Hooks methods of a single object: the object's vptr is swapped to a private copy of its
+// vtable, so other instances of the class are untouched. Slots of the copy can be changed
+// before or after Apply(); Apply/Restore are one interlocked store of the vptr.
+class VTableInstanceHook : public MemoryOperation
+{
+public:
+    // methodCount 0 = count the leading entries that point into executable memory
+    VTableInstanceHook(uintptr_t object, size_t methodCount = 0);
+    ~VTableInstanceHook();
+
+    bool   Apply()   override;
+    bool   Restore() override;
+    size_t GetLength() const override { return sizeof(uintptr_t); }
+
+    bool      HookMethod(size_t index, uintptr_t replacement);
+    bool      UnhookMethod(size_t index);
+    uintptr_t GetOriginal(size_t index) const;
+
+    template<typename T>
+    T GetOriginal(size_t index) const { return reinterpret_cast<T>(GetOriginal(index)); }
+
+    size_t GetMethodCount() const { return methodCount; }
+
+    static size_t CountMethods(uintptr_t vtable, size_t limit = 1024);
+
+private:
+    uintptr_t* Slots() const { return table.get() + 1; }
+
+    uintptr_t                   originalVTable = 0;
+    size_t                      methodCount = 0;
+    std::unique_ptr<uintptr_t[]> table;   // [0] = RTTI locator (vtable[-1]), then the methods
+};
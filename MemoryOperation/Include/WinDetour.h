@@ -5,7 +5,9 @@
 class WinDetour : public MemoryOperation
 {
 public:
-    WinDetour(PVOID* targetAddress, PVOID detourFunction);
+    // softToggle: Detours is pointed at a ToggleStub in front of detourFunction, so the hook
+    // is attached once and SetEnabled() only flips a flag
+    WinDetour(PVOID* targetAddress, PVOID detourFunction, bool softToggle = false);
 
     ~WinDetour();
 
@@ -16,13 +18,27 @@ public:
  
     bool IsApplied() const { return is_modified; }
 
-  
+    // Soft-toggled: one release store (attaching first if needed). Otherwise Apply()/Restore().
+    bool SetEnabled(bool enabled);
+    bool IsEnabled() const;
+    bool IsSoftToggle() const { return toggle != nullptr; }
+
+    // Attach/detach several detours in one Detours transaction that suspends and updates
+    // every thread of the process. A detour Detours rejects is dropped from the transaction
+    // and the rest are committed without it. errors (optional) receives one code per entry,
+    // NO_ERROR for success. Returns the number of detours whose state changed.
+    static size_t AttachBatch(const std::vector<WinDetour*>& detours, std::vector<LONG>* errors = nullptr);
+    static size_t DetachBatch(const std::vector<WinDetour*>& detours, std::vector<LONG>* errors = nullptr);
+
 
 private:
     PVOID*    targetAddress;
     PVOID     HookAddress;
     PVOID     targetStorage;
+    uint8_t*  toggle = nullptr;
     bool      IsValid();
 
+    static size_t CommitBatch(const std::vector<WinDetour*>& detours, bool attach, std::vector<LONG>* errors);
+
 
 };
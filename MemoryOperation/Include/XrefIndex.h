@@ -0,0 +1,90 @@
+#pragma once
+#include "ModuleCache.h"
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cross-references of one module: who calls, jumps to or references an address.
+// Built by a linear sweep with InstructionDecoder over the executable sections, split into
+// chunks decoded in parallel. On x64 each chunk starts at a .pdata function start, so chunks
+// begin on real instruction boundaries. References are kept as (target rva, source rva) sorted
+// by target, so a query is a binary search. The index is cached like Symbolizer's and
+// SignatureIndex's, keyed by module name, TimeDateStamp and SizeOfImage.
+class XrefIndex
+{
+public:
+    enum class Kind : uint8_t
+    {
+        Call,       // E8 rel32
+        Jump,       // E9/EB
+        CondJump,   // Jcc, LOOP/JCXZ
+        Data,       // [rip+disp] operand, or a base-relocated absolute address
+    };
+
+    struct Xref
+    {
+        uintptr_t source;   // address of the referencing instruction
+        uintptr_t target;
+        Kind      kind;
+    };
+
+    // Indexes moduleBase (the main module if 0). Throws std::invalid_argument if it is not a
+    // PE image with executable sections.
+    explicit XrefIndex(uintptr_t moduleBase = 0);
+    XrefIndex(const XrefIndex&) = delete;
+    XrefIndex& operator=(const XrefIndex&) = delete;
+
+    // References to target, ordered by source
+    std::vector<Xref> To(uintptr_t target) const;
+    // References to any address in [first, last), e.g. the fields of a global struct
+    std::vector<Xref> ToRange(uintptr_t first, uintptr_t last) const;
+
+    uintptr_t GetModuleBase() const { return moduleBase; }
+    size_t    GetCount() const { return count; }
+    bool      IsFromCache() const { return cache.IsOpen(); }
+
+    // Cache files go to %TEMP%\MemoryOperation\xrefs unless set; "" disables the cache
+    static void SetCacheDirectory(const std::string& directory);
+
+private:
+    struct Entry
+    {
+        uint32_t target;   // rvas, so the cache survives rebasing
+        uint32_t source;
+        uint8_t  kind;
+        uint8_t  reserved[3];
+    };
+
+    struct Section
+    {
+        uint32_t rva;
+        uint32_t size;
+    };
+
+    struct Relocation
+    {
+        uint32_t rva;
+        uint8_t  width;   // 4 (HIGHLOW) or 8 (DIR64)
+    };
+
+    uintptr_t             moduleBase = 0;
+    ModuleCache::Identity module;
+
+    std::vector<Section>    sections;
+    std::vector<Relocation> relocations;     // sorted by rva
+    std::vector<uint32_t>   functionStarts;  // .pdata begin rvas, sorted (x64)
+
+    const Entry* entries = nullptr;
+    size_t       count = 0;
+
+    // backing storage: the mapped cache file, or what was built in memory
+    ModuleCache::Mapping cache;
+    std::vector<Entry>   built;
+
+    void ReadImage();
+    void Build();
+    void Sweep(uint32_t first, uint32_t end, uint32_t sectionEnd, std::vector<Entry>& out) const;
+    bool MapCache(const std::string& path);
+    void WriteCache(const std::string& path) const;
+};
@@ -1,11 +1,80 @@
 #include "Breakpoint.h"
+#include "ProcessThreads.h"
+#include "Memory.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
 #include <stdio.h>
 
 // Static member initialization
-Breakpoint::BPInfo Breakpoint::s_breakpoints[4] = {};
+std::atomic<const Breakpoint::Table*> Breakpoint::s_table{ nullptr };
 bool Breakpoint::s_handlerInstalled = false;
 PVOID Breakpoint::s_vehHandle = nullptr;
 
+namespace
+{
+    // Writers of s_table serialize here and retire the old table instead of freeing it
+    std::mutex                g_writeMutex;
+    std::vector<const void*>  g_retiredTables;
+
+    // Value of each slot's watched range at its last hit. Kept outside the table
+    // because it changes on every hit.
+    std::atomic<uint64_t> g_lastValue[DebugRegisters::kCount];
+
+    // Execution breakpoints of this thread disabled for one single-step
+    thread_local uint32_t t_rearmMask = 0;
+
+    // Watch hits of one thread. The owning thread is the only producer and DrainHits the
+    // only consumer, so head and tail need no lock.
+    struct HitRing {
+        std::atomic<uint32_t> head{ 0 };
+        std::atomic<uint32_t> tail{ 0 };
+        Breakpoint::WatchHit  hits[Breakpoint::kHitRingSize];
+        HitRing*              next = nullptr;
+    };
+
+    // Every ring ever created, pushed lock-free. Rings are never freed: a drained ring
+    // of an exited thread is a few KB.
+    std::atomic<HitRing*> g_rings{ nullptr };
+    std::atomic<uint64_t> g_droppedHits{ 0 };
+    std::mutex            g_drainMutex;
+
+    // First use is inside the exception handler, which may have interrupted a heap call,
+    // so the ring comes from VirtualAlloc rather than new.
+    HitRing* ThreadRing() {
+        thread_local HitRing* ring = nullptr;
+        if (!ring) {
+            void* mem = VirtualAlloc(nullptr, sizeof(HitRing), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (!mem) {
+                return nullptr;
+            }
+            ring = new (mem) HitRing();
+
+            HitRing* head = g_rings.load(std::memory_order_acquire);
+            do {
+                ring->next = head;
+            } while (!g_rings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_acquire));
+        }
+        return ring;
+    }
+}
+
+// Current breakpoint table (an empty one before the first Publish)
+const Breakpoint::Table& Breakpoint::Current() {
+    static const Table empty{};
+    const Table* table = s_table.load(std::memory_order_acquire);
+    return table ? *table : empty;
+}
+
+// Swap in a copy of next; call with g_writeMutex held
+void Breakpoint::Publish(const Table& next) {
+    const Table* old = s_table.exchange(new Table(next), std::memory_order_acq_rel);
+    if (old) {
+        g_retiredTables.push_back(old);
+    }
+}
+
 // Install the vectored exception handler (once)
 void Breakpoint::InstallHandler() {
     if (!s_handlerInstalled) {
@@ -15,9 +84,9 @@ void Breakpoint::InstallHandler() {
 }
 
 // Find a free debug register (DR0-DR3)
-int Breakpoint::FindFreeDebugRegister() {
+int Breakpoint::FindFreeDebugRegister(const Table& table) {
     for (int i = 0; i < 4; i++) {
-        if (!s_breakpoints[i].enabled) {
+        if (!table.entries[i].enabled) {
             return i;
         }
     }
@@ -25,57 +94,85 @@ int Breakpoint::FindFreeDebugRegister() {
 }
 
 // Apply all active breakpoints to a given context
-void Breakpoint::ApplyBreakpointsToContext(CONTEXT& ctx) {
-    ctx.Dr7 = 0;
+void Breakpoint::ApplyBreakpointsToContext(CONTEXT& ctx, const Table& table) {
+    uint64_t dr7 = 0;
 
     for (int i = 0; i < 4; i++) {
-        if (s_breakpoints[i].enabled) {
+        const BPInfo& bp = table.entries[i];
+        if (bp.enabled) {
             switch (i) {
-            case 0: ctx.Dr0 = s_breakpoints[i].address; break;
-            case 1: ctx.Dr1 = s_breakpoints[i].address; break;
-            case 2: ctx.Dr2 = s_breakpoints[i].address; break;
-            case 3: ctx.Dr3 = s_breakpoints[i].address; break;
+            case 0: ctx.Dr0 = bp.address; break;
+            case 1: ctx.Dr1 = bp.address; break;
+            case 2: ctx.Dr2 = bp.address; break;
+            case 3: ctx.Dr3 = bp.address; break;
             }
 
-            // Set DR7 bits for execution breakpoint (RW=00, LEN=00, L=1)
-            // L bit (local enable) is at position (i * 2)
-            ctx.Dr7 |= (1ULL << (i * 2));
-
-            // Condition bits: RW (bits 16-17, 20-21, 24-25, 28-29) = 00 for execution
-            // LEN bits (bits 18-19, 22-23, 26-27, 30-31) = 00 for 1 byte
-            // These are already 0, so no need to set them
+            // Execution breakpoints are RW=00, LEN=00; watchpoints carry their own
+            dr7 = DebugRegisters::Enable(dr7, i, bp.condition, bp.length);
         }
     }
 
     // Enable general and local exact breakpoint detection
-    ctx.Dr7 |= 0x300;
+    ctx.Dr7 = static_cast<DWORD_PTR>(dr7 | DebugRegisters::kExactBits);
 }
 
-// Update debug registers in the current thread
-void Breakpoint::UpdateDebugRegisters() {
+// Clear one breakpoint's enable bits, leaving the others as the thread has them
+void Breakpoint::ClearBreakpointInContext(CONTEXT& ctx, int drIndex) {
+    ctx.Dr7 = static_cast<DWORD_PTR>(DebugRegisters::Disable(ctx.Dr7, drIndex));
+}
+
+void Breakpoint::ApplyEdit(CONTEXT& ctx, int) {
+    ApplyBreakpointsToContext(ctx, Current());
+}
+
+// Read-modify-write the debug registers of one thread
+bool Breakpoint::EditThread(HANDLE thread, ContextEdit edit, int drIndex) {
     CONTEXT ctx = {};
     ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
 
-    HANDLE hThread = GetCurrentThread();
-    if (GetThreadContext(hThread, &ctx)) {
-        ApplyBreakpointsToContext(ctx);
-        SetThreadContext(hThread, &ctx);
+    if (!GetThreadContext(thread, &ctx)) {
+        return false;
     }
+    edit(ctx, drIndex);
+    return SetThreadContext(thread, &ctx) != FALSE;
 }
 
-// Disable a specific breakpoint by index
-void Breakpoint::DisableBreakpoint(int drIndex) {
-    if (drIndex < 0 || drIndex >= 4) return;
+// One pass over the threads. Each thread is suspended only while its own context is
+// written, so no thread waits on the others. Threads created during the pass pick up
+// the new state from the TLS callback, since the new table is already published.
+void Breakpoint::EditAllThreads(ContextEdit edit, int drIndex) {
+    EditThread(GetCurrentThread(), edit, drIndex);
 
-    CONTEXT ctx = {};
-    ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
-    HANDLE hThread = GetCurrentThread();
+    std::vector<HANDLE> threads = ProcessThreads::OpenOthers(
+        THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_SET_CONTEXT);
+
+    int failed = 0;
+    for (HANDLE thread : threads) {
+        if (SuspendThread(thread) == (DWORD)-1) {
+            failed++;
+            continue;
+        }
+        if (!EditThread(thread, edit, drIndex)) {
+            failed++;
+        }
+        ResumeThread(thread);
+    }
 
-    if (GetThreadContext(hThread, &ctx)) {
-        // Clear the local enable bit for this DR
-        ctx.Dr7 &= ~(1ULL << (drIndex * 2));
-        SetThreadContext(hThread, &ctx);
+    if (failed) {
+        printf("[Breakpoint] Debug registers not updated on %d of %zu threads\n", failed, threads.size());
     }
+    ProcessThreads::CloseAll(threads);
+}
+
+// Update debug registers in every thread
+void Breakpoint::UpdateDebugRegisters() {
+    EditAllThreads(ApplyEdit, -1);
+}
+
+// Disable a specific breakpoint by index
+void Breakpoint::DisableBreakpoint(int drIndex) {
+    if (drIndex < 0 || drIndex >= 4) return;
+    EditAllThreads(ClearBreakpointInContext, drIndex);
 }
 
 // Enable a specific breakpoint by index
@@ -84,74 +181,66 @@ void Breakpoint::EnableBreakpoint(int drIndex) {
     UpdateDebugRegisters();
 }
 
-// Main exception handler
+// Main exception handler. Reads only the published table and this thread's state:
+// the slot comes from DR6, and the re-arm after an execution breakpoint is tracked per
+// thread, so concurrent hits on other threads cannot consume or clear it.
 LONG WINAPI Breakpoint::ExceptionHandler(PEXCEPTION_POINTERS ex) {
-    DWORD exceptionCode = ex->ExceptionRecord->ExceptionCode;
-
-    // Handle single-step exception (for re-enabling breakpoints)
-    if (exceptionCode == EXCEPTION_SINGLE_STEP) {
-        PCONTEXT ctx = ex->ContextRecord;
-
-        // Check if this was our single-step
-        bool ourStep = false;
-        for (int i = 0; i < 4; i++) {
-            if (s_breakpoints[i].singleStepping) {
-                s_breakpoints[i].singleStepping = false;
-                ourStep = true;
-            }
-        }
+    if (ex->ExceptionRecord->ExceptionCode != EXCEPTION_SINGLE_STEP) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
 
-        if (ourStep) {
-            // Re-enable all breakpoints
-            ApplyBreakpointsToContext(*ctx);
-            ctx->EFlags &= ~0x100; // Clear trap flag
-            return EXCEPTION_CONTINUE_EXECUTION;
+    PCONTEXT ctx = ex->ContextRecord;
+    const Table& table = Current();
+    const uint64_t dr6 = ctx->Dr6;
+    bool handled = false;
+
+    // Data watchpoints trap after the access and need no re-arm, only logging.
+    // One instruction can trigger several slots, so walk the set DR6 bits.
+    uint64_t hits = dr6 & 0xF;
+    for (int i = DebugRegisters::HitIndex(hits); i >= 0; i = DebugRegisters::HitIndex(hits)) {
+        hits &= ~(1ULL << i);
+        const BPInfo& bp = table.entries[i];
+        if (bp.enabled && bp.condition != DebugRegisters::Condition::Execute) {
+            RecordWatchHit(bp, ctx);
+            handled = true;
         }
+    }
 
-        // Check which debug register triggered
-        DWORD_PTR dr6 = ctx->Dr6;
+    // The single-step that follows one of our execution breakpoints on this thread
+    if (t_rearmMask != 0 && DebugRegisters::IsSingleStep(dr6)) {
+        t_rearmMask = 0;
+        ApplyBreakpointsToContext(*ctx, table);
+        ctx->EFlags &= ~0x100; // Clear trap flag
+        ctx->Dr6 = 0;
+        return EXCEPTION_CONTINUE_EXECUTION;
+    }
 
-        for (int i = 0; i < 4; i++) {
-            if ((dr6 & (1ULL << i)) && s_breakpoints[i].enabled) {
-                DWORD_PTR hitAddr;
+    const int i = DebugRegisters::HitIndex(dr6);
+    if (i >= 0) {
+        const BPInfo& bp = table.entries[i];
 #ifdef _WIN64
-                hitAddr = ctx->Rip;
+        const DWORD_PTR hitAddr = ctx->Rip;
 #else
-                hitAddr = ctx->Eip;
+        const DWORD_PTR hitAddr = ctx->Eip;
 #endif
-
-                if (hitAddr == s_breakpoints[i].address) {
-                    // Call the user callback
-                    if (s_breakpoints[i].callback) {
-                        s_breakpoints[i].callback(ctx);
-                    }
-
-                    // Temporarily disable this breakpoint and enable single-step
-                    switch (i) {
-                    case 0: ctx->Dr0 = 0; break;
-                    case 1: ctx->Dr1 = 0; break;
-                    case 2: ctx->Dr2 = 0; break;
-                    case 3: ctx->Dr3 = 0; break;
-                    }
-                    ctx->Dr7 &= ~(1ULL << (i * 2));
-
-                    // Set trap flag for single-step
-                    ctx->EFlags |= 0x100;
-                    s_breakpoints[i].singleStepping = true;
-
-                    // Clear the debug status register
-                    ctx->Dr6 = 0;
-
-                    return EXCEPTION_CONTINUE_EXECUTION;
-                }
+        if (bp.enabled && bp.condition == DebugRegisters::Condition::Execute && hitAddr == bp.address) {
+            // Call the user callback
+            if (bp.callback) {
+                bp.callback(ctx);
             }
-        }
 
-        // Clear Dr6 to acknowledge the exception
-        ctx->Dr6 = 0;
+            // Step over the instruction with this slot off, then re-arm it
+            ctx->Dr7 = static_cast<DWORD_PTR>(DebugRegisters::Disable(ctx->Dr7, i));
+            ctx->EFlags |= 0x100;
+            t_rearmMask |= 1u << i;
+            handled = true;
+        }
     }
 
-    return EXCEPTION_CONTINUE_SEARCH;
+    // Clear Dr6 to acknowledge the exception
+    ctx->Dr6 = 0;
+
+    return handled ? EXCEPTION_CONTINUE_EXECUTION : EXCEPTION_CONTINUE_SEARCH;
 }
 
 // Set a hardware breakpoint
@@ -160,6 +249,8 @@ bool Breakpoint::Set(DWORD_PTR address, Callback callback) {
         return false;
     }
 
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+
     // Check if already set
     if (IsSet(address)) {
         return false;
@@ -167,31 +258,34 @@ bool Breakpoint::Set(DWORD_PTR address, Callback callback) {
 
     InstallHandler();
 
-    int drIndex = FindFreeDebugRegister();
+    Table next = Current();
+    int drIndex = FindFreeDebugRegister(next);
     if (drIndex < 0) {
         return false; // No free debug registers
     }
 
-    s_breakpoints[drIndex].address = address;
-    s_breakpoints[drIndex].callback = callback;
-    s_breakpoints[drIndex].index = drIndex;
-    s_breakpoints[drIndex].enabled = true;
-    s_breakpoints[drIndex].singleStepping = false;
+    BPInfo& bp = next.entries[drIndex];
+    bp = BPInfo{};
+    bp.address = address;
+    bp.callback = callback;
+    bp.index = drIndex;
+    bp.enabled = true;
 
+    Publish(next);
     UpdateDebugRegisters();
     return true;
 }
 
 // Remove a hardware breakpoint
 bool Breakpoint::Remove(DWORD_PTR address) {
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+
+    Table next = Current();
     for (int i = 0; i < 4; i++) {
-        if (s_breakpoints[i].enabled && s_breakpoints[i].address == address) {
-            s_breakpoints[i].enabled = false;
-            s_breakpoints[i].address = 0;
-            s_breakpoints[i].callback = nullptr;
-            s_breakpoints[i].index = -1;
-            s_breakpoints[i].singleStepping = false;
+        if (next.entries[i].enabled && next.entries[i].address == address) {
+            next.entries[i] = BPInfo{};
 
+            Publish(next);
             UpdateDebugRegisters();
             return true;
         }
@@ -201,20 +295,117 @@ bool Breakpoint::Remove(DWORD_PTR address) {
 
 // Remove all breakpoints
 void Breakpoint::RemoveAll() {
-    for (int i = 0; i < 4; i++) {
-        s_breakpoints[i].enabled = false;
-        s_breakpoints[i].address = 0;
-        s_breakpoints[i].callback = nullptr;
-        s_breakpoints[i].index = -1;
-        s_breakpoints[i].singleStepping = false;
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+
+    Publish(Table{});
+    UpdateDebugRegisters();
+}
+
+// Set a data watchpoint
+bool Breakpoint::Watch(DWORD_PTR address, size_t length, Access access, WatchCallback callback) {
+    const DebugRegisters::Condition condition = access == Access::Write
+        ? DebugRegisters::Condition::Write
+        : DebugRegisters::Condition::ReadWrite;
+
+    if (address == 0 || !DebugRegisters::IsValid(address, condition, length)) {
+        return false;
+    }
+#ifndef _WIN64
+    if (length == 8) {
+        return false; // LEN=10 is only defined in 64-bit mode
+    }
+#endif
+    if (Memory::IsBadRange(address, length, false)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+
+    if (IsSet(address)) {
+        return false;
+    }
+
+    InstallHandler();
+
+    Table next = Current();
+    int drIndex = FindFreeDebugRegister(next);
+    if (drIndex < 0) {
+        return false; // No free debug registers
     }
+
+    BPInfo& bp = next.entries[drIndex];
+    bp = BPInfo{};
+    bp.address = address;
+    bp.index = drIndex;
+    bp.condition = condition;
+    bp.length = length;
+    bp.watchCallback = callback;
+    bp.enabled = true;
+
+    uint64_t value = 0;
+    memcpy(&value, reinterpret_cast<const void*>(address), length);
+    g_lastValue[drIndex].store(value, std::memory_order_relaxed);
+
+    Publish(next);
     UpdateDebugRegisters();
+    return true;
+}
+
+// Log a watchpoint hit into the calling thread's ring and run its callback
+void Breakpoint::RecordWatchHit(const BPInfo& bp, PCONTEXT ctx) {
+    WatchHit hit;
+    hit.address = bp.address;
+#ifdef _WIN64
+    hit.pc = ctx->Rip;
+#else
+    hit.pc = ctx->Eip;
+#endif
+    hit.threadId = GetCurrentThreadId();
+    memcpy(&hit.newValue, reinterpret_cast<const void*>(bp.address), bp.length);
+
+    // Threads hitting the same watch race here; the exchange keeps every old/new pair consistent
+    hit.oldValue = g_lastValue[bp.index].exchange(hit.newValue, std::memory_order_acq_rel);
+
+    HitRing* ring = ThreadRing();
+    const uint32_t head = ring ? ring->head.load(std::memory_order_relaxed) : 0;
+    if (!ring || head - ring->tail.load(std::memory_order_acquire) >= kHitRingSize) {
+        g_droppedHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        ring->hits[head % kHitRingSize] = hit;
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    if (bp.watchCallback) {
+        bp.watchCallback(hit, ctx);
+    }
+}
+
+// Collect the logged hits of every thread
+std::vector<Breakpoint::WatchHit> Breakpoint::DrainHits() {
+    std::vector<WatchHit> hits;
+    std::lock_guard<std::mutex> lock(g_drainMutex);
+
+    for (HitRing* ring = g_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        const uint32_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            hits.push_back(ring->hits[tail % kHitRingSize]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    return hits;
+}
+
+uint64_t Breakpoint::GetDroppedHits() {
+    return g_droppedHits.load(std::memory_order_relaxed);
 }
 
 // Check if a breakpoint is set at an address
 bool Breakpoint::IsSet(DWORD_PTR address) {
+    const Table& table = Current();
     for (int i = 0; i < 4; i++) {
-        if (s_breakpoints[i].enabled && s_breakpoints[i].address == address) {
+        if (table.entries[i].enabled && table.entries[i].address == address) {
             return true;
         }
     }
@@ -223,9 +414,10 @@ bool Breakpoint::IsSet(DWORD_PTR address) {
 
 // Get count of active breakpoints
 int Breakpoint::GetCount() {
+    const Table& table = Current();
     int count = 0;
     for (int i = 0; i < 4; i++) {
-        if (s_breakpoints[i].enabled) {
+        if (table.entries[i].enabled) {
             count++;
         }
     }
@@ -254,11 +446,42 @@ void Breakpoint::PrintRegisters(PCONTEXT ctx) {
 }
 
 // Get breakpoint info for a specific address
-Breakpoint::BPInfo* Breakpoint::GetBreakpointInfo(DWORD_PTR address) {
+const Breakpoint::BPInfo* Breakpoint::GetBreakpointInfo(DWORD_PTR address) {
+    const Table& table = Current();
     for (int i = 0; i < 4; i++) {
-        if (s_breakpoints[i].enabled && s_breakpoints[i].address == address) {
-            return &s_breakpoints[i];
+        if (table.entries[i].enabled && table.entries[i].address == address) {
+            return &table.entries[i];
         }
     }
     return nullptr;
-}
\ No newline at end of file
+}
+
+// Give the calling thread the current breakpoints
+void Breakpoint::ApplyToCurrentThread() {
+    if (GetCount() == 0) {
+        return;
+    }
+    EditThread(GetCurrentThread(), ApplyEdit, -1);
+}
+
+// TLS callback: new threads start with clear debug registers, so load ours on attach.
+// Runs on the new thread before its start routine.
+static void NTAPI BreakpointTlsCallback(PVOID, DWORD reason, PVOID) {
+    if (reason == DLL_THREAD_ATTACH) {
+        Breakpoint::ApplyToCurrentThread();
+    }
+}
+
+#ifdef _WIN64
+#pragma comment(linker, "/INCLUDE:_tls_used")
+#pragma comment(linker, "/INCLUDE:memop_breakpoint_tls")
+#pragma const_seg(".CRT$XLB")
+extern "C" const PIMAGE_TLS_CALLBACK memop_breakpoint_tls = BreakpointTlsCallback;
+#pragma const_seg()
+#else
+#pragma comment(linker, "/INCLUDE:__tls_used")
+#pragma comment(linker, "/INCLUDE:_memop_breakpoint_tls")
+#pragma data_seg(".CRT$XLB")
+extern "C" PIMAGE_TLS_CALLBACK memop_breakpoint_tls = BreakpointTlsCallback;
+#pragma data_seg()
+#endif
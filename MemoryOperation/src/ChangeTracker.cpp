@@ -0,0 +1,105 @@
+#include "ChangeTracker.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+void* ChangeTracker::Allocate(size_t size)
+{
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE);
+}
+
+void ChangeTracker::Free(void* address)
+{
+    if (address) VirtualFree(address, 0, MEM_RELEASE);
+}
+
+ChangeTracker::ChangeTracker(void* base, size_t size)
+    : base(reinterpret_cast<uintptr_t>(base)), size(size)
+{
+    if (!base || !size) {
+        throw std::invalid_argument("ChangeTracker: empty range");
+    }
+
+    SYSTEM_INFO sysInfo{};
+    GetSystemInfo(&sysInfo);
+    pageSize = sysInfo.dwPageSize;
+    pageCount = (size + (this->base & (pageSize - 1)) + pageSize - 1) / pageSize;
+
+    // GetWriteWatch fails unless the whole range was allocated with MEM_WRITE_WATCH.
+    // Reset before copying: a write racing the copy then stays dirty for the first Refresh
+    dirty.resize(pageCount);
+    ULONG_PTR count = dirty.size();
+    ULONG granularity = 0;
+    writeWatched = GetWriteWatch(WRITE_WATCH_FLAG_RESET, base, size, dirty.data(), &count, &granularity) == 0;
+    if (!writeWatched) {
+        std::vector<PVOID>().swap(dirty);
+    }
+
+    snapshot.resize(size);
+    memcpy(snapshot.data(), base, size);
+}
+
+bool ChangeTracker::Refresh(std::vector<Change>& changes)
+{
+    const uintptr_t firstPage = base & ~uintptr_t(pageSize - 1);
+
+    if (!writeWatched) {
+        for (size_t page = 0; page < pageCount; page++) {
+            ComparePage(page, changes);
+        }
+        lastDirtyPages = pageCount;
+        return true;
+    }
+
+    // Fetch and reset in one call: a write that lands after it is seen by the next Refresh
+    ULONG_PTR count = dirty.size();
+    ULONG granularity = 0;
+    if (GetWriteWatch(WRITE_WATCH_FLAG_RESET, reinterpret_cast<PVOID>(base), size, dirty.data(), &count, &granularity) != 0) {
+        return false;
+    }
+
+    // Addresses come back in ascending order, so the runs do too
+    for (ULONG_PTR i = 0; i < count; i++) {
+        ComparePage((reinterpret_cast<uintptr_t>(dirty[i]) - firstPage) / pageSize, changes);
+    }
+    lastDirtyPages = count;
+    return true;
+}
+
+// Compare one page with the snapshot word by word, append the changed runs, update the snapshot
+void ChangeTracker::ComparePage(size_t page, std::vector<Change>& changes)
+{
+    const uintptr_t firstPage = base & ~uintptr_t(pageSize - 1);
+    const uintptr_t start = (std::max)(firstPage + page * pageSize, base);
+    const uintptr_t end = (std::min)(firstPage + (page + 1) * pageSize, base + size);
+    if (start >= end) return;
+
+    const uint8_t* live = reinterpret_cast<const uint8_t*>(start);
+    uint8_t* saved = snapshot.data() + (start - base);
+    const size_t length = end - start;
+
+    size_t i = 0;
+    while (i < length) {
+        // Skip equal words quickly, then narrow down to the byte
+        while (i + sizeof(uintptr_t) <= length && memcmp(live + i, saved + i, sizeof(uintptr_t)) == 0) {
+            i += sizeof(uintptr_t);
+        }
+        while (i < length && live[i] == saved[i]) i++;
+        if (i >= length) break;
+
+        const size_t runStart = i;
+        while (i < length && live[i] != saved[i]) {
+            saved[i] = live[i];
+            i++;
+        }
+
+        // Extend the previous run if it ended right where this one starts (page boundary)
+        const uintptr_t address = start + runStart;
+        if (!changes.empty() && changes.back().address + changes.back().size == address) {
+            changes.back().size += i - runStart;
+        }
+        else {
+            changes.push_back({ address, i - runStart });
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include "CodeAllocator.h"
+
+std::vector<CodeAllocator::Block> CodeAllocator::blocks;
+std::mutex CodeAllocator::mutex;
+
+namespace
+{
+    constexpr size_t    kBlockSize = 0x10000;
+    constexpr uintptr_t kMaxDistance = 0x7FF00000;   // rel32 reach minus slack for the block itself
+
+    bool InReach(uintptr_t a, uintptr_t b)
+    {
+#ifdef _WIN64
+        return (a > b ? a - b : b - a) < kMaxDistance;
+#else
+        return true;
+#endif
+    }
+}
+
+uint8_t* CodeAllocator::Allocate(size_t size, uintptr_t nearAddress)
+{
+    size = (size + 15) & ~size_t(15);
+    if (!size || size > kBlockSize) return nullptr;
+
+    std::lock_guard lock(mutex);
+
+    for (auto& block : blocks) {
+        if (block.size - block.used >= size && InReach(block.base, nearAddress)) {
+            auto p = reinterpret_cast<uint8_t*>(block.base + block.used);
+            block.used += size;
+            return p;
+        }
+    }
+
+    const uintptr_t base = AllocateBlockNear(nearAddress, kBlockSize);
+    if (!base) return nullptr;
+
+    blocks.push_back(Block{ base, size, kBlockSize });
+    return reinterpret_cast<uint8_t*>(base);
+}
+
+uintptr_t CodeAllocator::AllocateBlockNear(uintptr_t nearAddress, size_t size)
+{
+#ifndef _WIN64
+    (void)nearAddress;
+    return reinterpret_cast<uintptr_t>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+#else
+    SYSTEM_INFO si{};
+    GetSystemInfo(&si);
+    const uintptr_t granularity = si.dwAllocationGranularity;
+    const uintptr_t appMin = reinterpret_cast<uintptr_t>(si.lpMinimumApplicationAddress);
+    const uintptr_t appMax = reinterpret_cast<uintptr_t>(si.lpMaximumApplicationAddress);
+
+    const uintptr_t lo = nearAddress > kMaxDistance + appMin ? nearAddress - kMaxDistance : appMin;
+    const uintptr_t hi = nearAddress < appMax - kMaxDistance ? nearAddress + kMaxDistance : appMax;
+    const uintptr_t start = nearAddress & ~(granularity - 1);
+
+    auto tryAt = [&](uintptr_t addr) -> uintptr_t {
+        return reinterpret_cast<uintptr_t>(VirtualAlloc(reinterpret_cast<LPVOID>(addr), size,
+            MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE));
+    };
+
+    // Walk down from the target first (images usually sit high, free space below), then up,
+    // skipping whole regions via VirtualQuery instead of probing every granule.
+    for (uintptr_t addr = start; addr > lo && addr - lo >= granularity;) {
+        addr -= granularity;
+        MEMORY_BASIC_INFORMATION mbi{};
+        if (!VirtualQuery(reinterpret_cast<LPCVOID>(addr), &mbi, sizeof(mbi))) break;
+
+        if (mbi.State == MEM_FREE) {
+            if (uintptr_t p = tryAt(addr)) return p;
+        }
+        else {
+            addr = reinterpret_cast<uintptr_t>(mbi.AllocationBase) & ~(granularity - 1);
+        }
+    }
+
+    for (uintptr_t addr = start + granularity; addr < hi;) {
+        MEMORY_BASIC_INFORMATION mbi{};
+        if (!VirtualQuery(reinterpret_cast<LPCVOID>(addr), &mbi, sizeof(mbi))) break;
+
+        if (mbi.State == MEM_FREE) {
+            if (uintptr_t p = tryAt(addr)) return p;
+            addr += granularity;
+        }
+        else {
+            const uintptr_t next = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+            addr = (next + granularity - 1) & ~(granularity - 1);
+        }
+    }
+
+    return 0;
+#endif
+}
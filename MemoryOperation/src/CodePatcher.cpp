@@ -0,0 +1,115 @@
+#include "CodePatcher.h"
+#include <algorithm>
+#include <cstring>
+#include <intrin.h>
+
+bool CodePatcher::IsAtomic(uintptr_t address, size_t size)
+{
+    if (!size) return false;
+    if ((address & ~uintptr_t(7)) + 8 >= address + size) return true;
+#ifdef _WIN64
+    if ((address & ~uintptr_t(15)) + 16 >= address + size) return true;
+#endif
+    return false;
+}
+
+bool CodePatcher::Store(uintptr_t address, const void* data, size_t size)
+{
+    const uintptr_t aligned8 = address & ~uintptr_t(7);
+    if (aligned8 + 8 >= address + size) {
+        auto word = reinterpret_cast<volatile LONG64*>(aligned8);
+        LONG64 expected = *word;
+        for (;;) {
+            LONG64 desired = expected;
+            std::memcpy(reinterpret_cast<uint8_t*>(&desired) + (address - aligned8), data, size);
+            const LONG64 seen = InterlockedCompareExchange64(word, desired, expected);
+            if (seen == expected) return true;
+            expected = seen;
+        }
+    }
+
+#ifdef _WIN64
+    const uintptr_t aligned16 = address & ~uintptr_t(15);
+    if (aligned16 + 16 >= address + size) {
+        auto words = reinterpret_cast<volatile LONG64*>(aligned16);
+        alignas(16) LONG64 expected[2] = { words[0], words[1] };
+        for (;;) {
+            alignas(16) LONG64 desired[2] = { expected[0], expected[1] };
+            std::memcpy(reinterpret_cast<uint8_t*>(desired) + (address - aligned16), data, size);
+            // on failure 'expected' is refreshed with the current contents
+            if (_InterlockedCompareExchange128(words, desired[1], desired[0], expected)) return true;
+        }
+    }
+#endif
+
+    std::memcpy(reinterpret_cast<void*>(address), data, size);
+    return true;
+}
+
+bool CodePatcher::Write(uintptr_t address, const void* data, size_t size)
+{
+    if (!address || !data || !size) return false;
+
+    DWORD old_protection;
+    if (!VirtualProtect(reinterpret_cast<LPVOID>(address), size, PAGE_EXECUTE_READWRITE, &old_protection))
+        return false;
+
+    const bool ok = Store(address, data, size);
+
+    DWORD temp;
+    VirtualProtect(reinterpret_cast<LPVOID>(address), size, old_protection, &temp);
+    FlushInstructionCache(GetCurrentProcess(), reinterpret_cast<LPCVOID>(address), size);
+    return ok;
+}
+
+size_t CodePatcher::WriteBatch(std::vector<Edit>& edits)
+{
+    constexpr uintptr_t kPage = 0x1000;
+
+    std::vector<Edit*> order;
+    order.reserve(edits.size());
+    for (Edit& edit : edits) {
+        edit.written = false;
+        if (edit.address && edit.data && edit.size) order.push_back(&edit);
+    }
+    std::sort(order.begin(), order.end(), [](const Edit* a, const Edit* b) { return a->address < b->address; });
+
+    size_t written = 0;
+    for (size_t first = 0; first < order.size();) {
+        // Group the edits that start on the same page; the protected span is extended if
+        // the last one runs into the next page
+        const uintptr_t page = order[first]->address & ~(kPage - 1);
+        size_t last = first;
+        uintptr_t end = order[first]->address + order[first]->size;
+        while (last + 1 < order.size() && (order[last + 1]->address & ~(kPage - 1)) == page) {
+            last++;
+            end = (std::max)(end, order[last]->address + order[last]->size);
+        }
+
+        // One VirtualProtect only restores correctly if the whole span has one protection
+        MEMORY_BASIC_INFORMATION mbi{};
+        DWORD old_protection;
+        const bool uniform = VirtualQuery(reinterpret_cast<LPCVOID>(page), &mbi, sizeof(mbi)) &&
+            reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize >= end;
+
+        if (uniform && VirtualProtect(reinterpret_cast<LPVOID>(page), end - page, PAGE_EXECUTE_READWRITE, &old_protection)) {
+            for (size_t i = first; i <= last; i++) {
+                order[i]->written = Store(order[i]->address, order[i]->data, order[i]->size);
+                written += order[i]->written;
+            }
+
+            DWORD temp;
+            VirtualProtect(reinterpret_cast<LPVOID>(page), end - page, old_protection, &temp);
+            FlushInstructionCache(GetCurrentProcess(), reinterpret_cast<LPCVOID>(page), end - page);
+        }
+        else {
+            for (size_t i = first; i <= last; i++) {
+                order[i]->written = Write(order[i]->address, order[i]->data, order[i]->size);
+                written += order[i]->written;
+            }
+        }
+
+        first = last + 1;
+    }
+    return written;
+}
@@ -0,0 +1,156 @@
+#include "CodeRelocator.h"
+#include "InstructionDecoder.h"
+#include <cstring>
+
+namespace
+{
+    void Put32(uint8_t* p, int32_t v) { std::memcpy(p, &v, sizeof(v)); }
+
+    int32_t Rel32(uintptr_t from, uintptr_t to)
+    {
+        return static_cast<int32_t>(static_cast<intptr_t>(to - from));
+    }
+
+#ifdef _WIN64
+    // jmp qword ptr [rip+0] ; dq target
+    size_t EmitAbsoluteJump(uint8_t* out, uintptr_t to)
+    {
+        out[0] = 0xFF; out[1] = 0x25;
+        Put32(out + 2, 0);
+        std::memcpy(out + 6, &to, sizeof(to));
+        return 14;
+    }
+#endif
+}
+
+bool CodeRelocator::InRel32(uintptr_t from, uintptr_t to)
+{
+    const intptr_t delta = static_cast<intptr_t>(to - from);
+    return delta >= INT32_MIN && delta <= INT32_MAX;
+}
+
+size_t CodeRelocator::EmitJump(uint8_t* out, uintptr_t from, uintptr_t to)
+{
+    if (InRel32(from + 5, to)) {
+        out[0] = 0xE9;
+        Put32(out + 1, Rel32(from + 5, to));
+        return 5;
+    }
+#ifdef _WIN64
+    return EmitAbsoluteJump(out, to);
+#else
+    return 0;
+#endif
+}
+
+size_t CodeRelocator::Relocate(uintptr_t source, size_t minLength, uint8_t* out, size_t capacity,
+    uintptr_t outAddress, size_t* stolen)
+{
+    const bool x64 = InstructionDecoder::kNative64;
+    size_t consumed = 0;
+    size_t written = 0;
+
+    uintptr_t branchTargets[16];
+    size_t branchCount = 0;
+
+    while (consumed < minLength) {
+        const auto code = reinterpret_cast<const uint8_t*>(source + consumed);
+        const uintptr_t at = source + consumed;
+        const uintptr_t dst = outAddress + written;
+
+        DecodedInstruction in;
+        if (!InstructionDecoder::Decode(code, 15, in, x64)) return 0;
+
+        // worst case below is 16 bytes for one instruction, keep room for the jump back
+        if (written + 16 + kMaxJumpSize > capacity) return 0;
+        uint8_t* o = out + written;
+
+        if (in.relSize) {
+            const uintptr_t target = in.BranchTarget(at, code);
+            if (branchCount < 16) branchTargets[branchCount++] = target;
+
+            if (!x64 && in.relSize == 2) return 0;              // 16-bit operand size branch
+
+            if (in.opcodeMap == 0 && in.opcode >= 0xE0 && in.opcode <= 0xE3)
+                return 0;                                       // LOOP/JCXZ only exist as rel8
+
+            const bool isCall = in.flow == DecodedInstruction::Flow::Call;
+            const bool isJump = in.flow == DecodedInstruction::Flow::Jump;
+
+            if (isJump) {
+                const size_t n = EmitJump(o, dst, target);
+                if (!n) return 0;
+                written += n;
+            }
+            else if (isCall) {
+                if (InRel32(dst + 5, target)) {
+                    o[0] = 0xE8;
+                    Put32(o + 1, Rel32(dst + 5, target));
+                    written += 5;
+                }
+                else {
+#ifdef _WIN64
+                    // call [rip+2] ; jmp +8 ; dq target
+                    o[0] = 0xFF; o[1] = 0x15; Put32(o + 2, 2);
+                    o[6] = 0xEB; o[7] = 0x08;
+                    std::memcpy(o + 8, &target, sizeof(target));
+                    written += 16;
+#else
+                    return 0;
+#endif
+                }
+            }
+            else {
+                // Jcc rel8 (7x) or rel32 (0F 8x): always emit the rel32 form
+                const uint8_t cc = in.opcode & 0x0F;
+                if (InRel32(dst + 6, target)) {
+                    o[0] = 0x0F; o[1] = static_cast<uint8_t>(0x80 | cc);
+                    Put32(o + 2, Rel32(dst + 6, target));
+                    written += 6;
+                }
+                else {
+#ifdef _WIN64
+                    // j!cc +14 ; jmp [rip+0] ; dq target
+                    o[0] = static_cast<uint8_t>(0x70 | (cc ^ 1)); o[1] = 14;
+                    EmitAbsoluteJump(o + 2, target);
+                    written += 16;
+#else
+                    return 0;
+#endif
+                }
+            }
+        }
+        else {
+            std::memcpy(o, code, in.length);
+
+            if (in.ripRelative) {
+                const uintptr_t target = in.RipTarget(at, code);
+                if (!InRel32(dst + in.length, target)) return 0;
+                Put32(o + in.dispOffset, Rel32(dst + in.length, target));
+            }
+            written += in.length;
+        }
+
+        consumed += in.length;
+
+        // nothing after an unconditional exit belongs to this function
+        if (consumed < minLength) {
+            using Flow = DecodedInstruction::Flow;
+            if (in.flow == Flow::Jump || in.flow == Flow::IndirectJump ||
+                in.flow == Flow::Return || in.flow == Flow::Interrupt)
+                return 0;
+        }
+    }
+
+    // a branch back into the bytes we are about to overwrite cannot be relocated
+    for (size_t i = 0; i < branchCount; ++i) {
+        if (branchTargets[i] >= source && branchTargets[i] < source + consumed) return 0;
+    }
+
+    const size_t back = EmitJump(out + written, outAddress + written, source + consumed);
+    if (!back) return 0;
+    written += back;
+
+    if (stolen) *stolen = consumed;
+    return written;
+}
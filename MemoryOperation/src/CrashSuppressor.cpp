@@ -1,10 +1,73 @@
 #include "CrashSuppressor.h"
+#include "InstructionDecoder.h"
+#include "Memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 
 PVOID CrashSuppressor::s_vectoredHandler = nullptr;
+LPTOP_LEVEL_EXCEPTION_FILTER CrashSuppressor::s_previousFilter = nullptr;
+
+namespace {
+    struct Slot {
+        std::atomic<uintptr_t> address{ 0 };
+        std::atomic<DWORD>     code{ 0 };
+        std::atomic<uint32_t>  count{ 0 };
+        std::atomic<uint32_t>  passed{ 0 };
+        std::atomic<uint32_t>  windowCount{ 0 };
+        std::atomic<ULONGLONG> windowStart{ 0 };
+    };
+
+    Slot                  g_sites[CrashSuppressor::kSiteCount];
+    Slot                  g_overflow;   // shared rate limit for faults that found no free slot
+    std::atomic<uint64_t> g_untracked{ 0 };
+
+    size_t SiteIndex(uintptr_t address) {
+        return static_cast<size_t>((static_cast<uint64_t>(address) * 0x9E3779B97F4A7C15ull) >> 40) & (CrashSuppressor::kSiteCount - 1);
+    }
+
+    // Claims or finds the slot for address without locking; null when the probe window is full
+    Slot* FindSlot(uintptr_t address) {
+        size_t index = SiteIndex(address);
+        for (size_t probe = 0; probe < CrashSuppressor::kMaxProbe; ++probe) {
+            Slot& slot = g_sites[index];
+            uintptr_t owner = slot.address.load(std::memory_order_acquire);
+            if (owner == address) return &slot;
+            if (owner == 0 && slot.address.compare_exchange_strong(owner, address, std::memory_order_acq_rel)) return &slot;
+            if (owner == address) return &slot;   // another thread claimed it for the same site
+            index = (index + 1) & (CrashSuppressor::kSiteCount - 1);
+        }
+        return nullptr;
+    }
+
+    // True while the slot is within kBurstLimit faults for the current window
+    bool Admit(Slot& slot) {
+        const ULONGLONG now = GetTickCount64();
+        ULONGLONG start = slot.windowStart.load(std::memory_order_relaxed);
+        if (now - start >= CrashSuppressor::kWindowMs &&
+            slot.windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            slot.windowCount.store(0, std::memory_order_relaxed);
+        }
+        return slot.windowCount.fetch_add(1, std::memory_order_relaxed) < CrashSuppressor::kBurstLimit;
+    }
+}
+
+CrashSuppressor::RecoveryPoint::RecoveryPoint() : previous(current) {
+    current = this;
+}
+
+CrashSuppressor::RecoveryPoint::~RecoveryPoint() {
+    current = previous;
+}
 
 void CrashSuppressor::Install() {
     if (!s_vectoredHandler) {
         s_vectoredHandler = AddVectoredExceptionHandler(1, ExceptionHandler);
+        if (s_vectoredHandler) {
+            s_previousFilter = SetUnhandledExceptionFilter(UnhandledFilter);
+        }
     }
 }
 
@@ -12,6 +75,13 @@ void CrashSuppressor::Remove() {
     if (s_vectoredHandler) {
         RemoveVectoredExceptionHandler(s_vectoredHandler);
         s_vectoredHandler = nullptr;
+
+        // Put the previous filter back, unless someone replaced ours in the meantime
+        LPTOP_LEVEL_EXCEPTION_FILTER current = SetUnhandledExceptionFilter(s_previousFilter);
+        if (current != UnhandledFilter) {
+            SetUnhandledExceptionFilter(current);
+        }
+        s_previousFilter = nullptr;
     }
 }
 
@@ -19,7 +89,160 @@ bool CrashSuppressor::IsInstalled() {
     return s_vectoredHandler != nullptr;
 }
 
+// Faults the suppressor may recover from. Single-step/breakpoint belong to Breakpoint and
+// SoftBreakpoint, guard pages to whoever set them, C++ exceptions to their catch blocks, and a
+// stack overflow cannot be resumed safely.
+bool CrashSuppressor::IsOwnedCode(DWORD code) {
+    switch (code) {
+    case EXCEPTION_ACCESS_VIOLATION:
+    case EXCEPTION_IN_PAGE_ERROR:
+    case EXCEPTION_ILLEGAL_INSTRUCTION:
+    case EXCEPTION_PRIV_INSTRUCTION:
+    case EXCEPTION_INT_DIVIDE_BY_ZERO:
+    case EXCEPTION_INT_OVERFLOW:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Records the fault; false when the site (or the overflow bucket) is over its rate limit
+bool CrashSuppressor::CountFault(uintptr_t address, DWORD code) {
+    Slot* slot = FindSlot(address);
+    if (!slot) {
+        g_untracked.fetch_add(1, std::memory_order_relaxed);
+        slot = &g_overflow;
+    }
+    slot->code.store(code, std::memory_order_relaxed);
+
+    if (!Admit(*slot)) {
+        slot->passed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slot->count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+size_t CrashSuppressor::SkipLength(const uint8_t* code, size_t available) {
+    DecodedInstruction insn;
+    if (!InstructionDecoder::Decode(code, available, insn)) {
+        return 0;
+    }
+
+    switch (insn.flow) {
+    case DecodedInstruction::Flow::None:
+    case DecodedInstruction::Flow::IndirectCall:   // as if the call returned, rax left as it was
+    case DecodedInstruction::Flow::CondJump:
+    case DecodedInstruction::Flow::Interrupt:      // UD2, INT n
+        return insn.length;
+    default:
+        // Skipping a return or a jump would run whatever follows it, which is not where the code was going
+        return 0;
+    }
+}
+
+bool CrashSuppressor::SkipInstruction(PCONTEXT ctx, uintptr_t pc) {
+    // The instruction may end at an unreadable page boundary; never read past it here
+    size_t available = 15;
+    if (Memory::IsBadRange(pc, available, false)) {
+        available = 0x1000 - (pc & 0xFFF);
+        if (available > 15 || Memory::IsBadRange(pc, available, false)) {
+            return false;
+        }
+    }
+
+    uint8_t code[15] = {};
+    memcpy(code, reinterpret_cast<const void*>(pc), available);
+
+    const size_t length = SkipLength(code, available);
+    if (!length) {
+        return false;
+    }
+#ifdef _WIN64
+    ctx->Rip = pc + length;
+#else
+    ctx->Eip = static_cast<DWORD>(pc + length);
+#endif
+    return true;
+}
+
+std::vector<CrashSuppressor::FaultSite> CrashSuppressor::GetSites() {
+    std::vector<FaultSite> sites;
+    for (const Slot& slot : g_sites) {
+        const uintptr_t address = slot.address.load(std::memory_order_acquire);
+        if (!address) continue;
+
+        FaultSite site;
+        site.address = address;
+        site.code = slot.code.load(std::memory_order_relaxed);
+        site.count = slot.count.load(std::memory_order_relaxed);
+        site.passed = slot.passed.load(std::memory_order_relaxed);
+        sites.push_back(site);
+    }
+    std::sort(sites.begin(), sites.end(), [](const FaultSite& a, const FaultSite& b) { return a.count > b.count; });
+    return sites;
+}
+
+uint64_t CrashSuppressor::GetUntrackedFaults() {
+    return g_untracked.load();
+}
+
+// Not synchronized with the handler: call when no faults are expected
+void CrashSuppressor::ResetSites() {
+    for (Slot& slot : g_sites) {
+        slot.count = 0;
+        slot.passed = 0;
+        slot.windowCount = 0;
+        slot.windowStart = 0;
+        slot.code = 0;
+        slot.address = 0;
+    }
+    g_overflow.count = 0;
+    g_overflow.passed = 0;
+    g_overflow.windowCount = 0;
+    g_overflow.windowStart = 0;
+    g_untracked = 0;
+}
+
+void CrashSuppressor::Dump() {
+    const std::vector<FaultSite> sites = GetSites();
+    std::cout << "[CrashSuppressor] " << sites.size() << " fault sites, " << GetUntrackedFaults() << " untracked faults" << std::endl;
+    for (const FaultSite& site : sites) {
+        printf("  0x%p  code 0x%08lX  suppressed %u  passed %u\n",
+            reinterpret_cast<void*>(site.address), static_cast<unsigned long>(site.code), site.count, site.passed);
+    }
+}
+
+// First chance: only recovery points. Anything else is left to the frame handlers
+// (Memory::Read's __try, catch blocks...) and reaches UnhandledFilter if none claims it.
 LONG NTAPI CrashSuppressor::ExceptionHandler(PEXCEPTION_POINTERS ExceptionInfo) {
-    // Suppress all crashes by continuing execution
+    RecoveryPoint* point = RecoveryPoint::current;
+    const DWORD code = ExceptionInfo->ExceptionRecord->ExceptionCode;
+    if (!point || !IsOwnedCode(code)) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    const uintptr_t pc = reinterpret_cast<uintptr_t>(ExceptionInfo->ExceptionRecord->ExceptionAddress);
+    if (!CountFault(pc, code)) {
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    point->faulted = true;
+    point->code = code;
+    point->address = pc;
+    *ExceptionInfo->ContextRecord = point->context;
     return EXCEPTION_CONTINUE_EXECUTION;
-}
\ No newline at end of file
+}
+
+// Last chance: nobody handled the fault, skip the instruction or let the previous filter decide
+LONG WINAPI CrashSuppressor::UnhandledFilter(PEXCEPTION_POINTERS ExceptionInfo) {
+    const DWORD code = ExceptionInfo->ExceptionRecord->ExceptionCode;
+    if (IsOwnedCode(code)) {
+        const uintptr_t pc = reinterpret_cast<uintptr_t>(ExceptionInfo->ExceptionRecord->ExceptionAddress);
+        if (CountFault(pc, code) && SkipInstruction(ExceptionInfo->ContextRecord, pc)) {
+            return EXCEPTION_CONTINUE_EXECUTION;
+        }
+    }
+
+    return s_previousFilter ? s_previousFilter(ExceptionInfo) : EXCEPTION_CONTINUE_SEARCH;
+}
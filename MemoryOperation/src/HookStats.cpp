@@ -0,0 +1,152 @@
+#include "HookStats.h"
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+std::atomic<bool>   HookStats::globalEnabled{ true };
+std::atomic<uint32_t> HookStats::freeShards{ (1u << HookStats::kShards) - 1 };
+
+namespace
+{
+    // Function-local so hooks declared in other translation units can register during static init
+    struct Registry
+    {
+        std::mutex               mutex;
+        std::vector<HookStats::Site*> sites;
+        uint64_t                 tscStart = __rdtsc();
+        LARGE_INTEGER            qpcStart = [] { LARGE_INTEGER t{}; QueryPerformanceCounter(&t); return t; }();
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+}
+
+HookStats::Site::Site(const char* name) : name(name)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.sites.push_back(this);
+}
+
+bool HookStats::SetEnabled(const std::string& name, bool enabled)
+{
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    bool found = false;
+    for (Site* site : registry.sites) {
+        if (name == site->name) {
+            site->enabled.store(enabled, std::memory_order_relaxed);
+            found = true;
+        }
+    }
+    return found;
+}
+
+double HookStats::CyclesPerNanosecond()
+{
+    // TSC rate from the time elapsed since the first hook registered
+    auto& registry = GetRegistry();
+    LARGE_INTEGER now{}, frequency{};
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    const uint64_t tsc = __rdtsc();
+
+    const double ns = double(now.QuadPart - registry.qpcStart.QuadPart) * 1e9 / double(frequency.QuadPart);
+    if (ns < 1e6) return 0;   // under a millisecond: not enough to calibrate, report cycles
+    return double(tsc - registry.tscStart) / ns;
+}
+
+double HookStats::Percentile(const uint64_t (&histogram)[kBuckets], double p)
+{
+    uint64_t total = 0;
+    for (uint64_t n : histogram) total += n;
+    if (!total) return 0;
+
+    // bucket b holds [2^(b-1), 2^b); interpolate linearly inside it
+    const double rank = p * double(total);
+    double seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+        if (!histogram[b]) continue;
+        if (seen + double(histogram[b]) >= rank) {
+            const double lo = b ? double(1ull << (b - 1)) : 0.0;
+            const double hi = double(1ull << b);
+            return lo + (hi - lo) * ((rank - seen) / double(histogram[b]));
+        }
+        seen += double(histogram[b]);
+    }
+    return double(1ull << (kBuckets - 1));
+}
+
+std::vector<HookStats::Summary> HookStats::Snapshot()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    const double cyclesPerNs = CyclesPerNanosecond();
+    const double scale = cyclesPerNs > 0 ? 1.0 / cyclesPerNs : 1.0;
+
+    std::vector<Summary> out;
+    out.reserve(registry.sites.size());
+
+    for (Site* site : registry.sites) {
+        Summary summary;
+        summary.name = site->name;
+        summary.enabled = site->enabled.load(std::memory_order_relaxed);
+
+        uint64_t hook[kBuckets]{}, original[kBuckets]{};
+        for (const Shard& shard : site->shards) {
+            summary.calls += shard.calls.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < kBuckets; ++b) {
+                hook[b] += shard.hook[b].load(std::memory_order_relaxed);
+                original[b] += shard.original[b].load(std::memory_order_relaxed);
+            }
+        }
+
+        summary.hookP50 = Percentile(hook, 0.50) * scale;
+        summary.hookP99 = Percentile(hook, 0.99) * scale;
+        summary.originalP50 = Percentile(original, 0.50) * scale;
+        summary.originalP99 = Percentile(original, 0.99) * scale;
+        out.push_back(std::move(summary));
+    }
+    return out;
+}
+
+void HookStats::Dump()
+{
+    const bool calibrated = CyclesPerNanosecond() > 0;
+    const char* unit = calibrated ? "ns" : "cyc";
+
+    std::cout << "[HookStats] " << std::left << std::setw(32) << "hook" << std::right
+        << std::setw(12) << "calls"
+        << std::setw(12) << "hook p50" << std::setw(12) << "hook p99"
+        << std::setw(12) << "orig p50" << std::setw(12) << "orig p99" << " (" << unit << ")\n";
+
+    for (const auto& s : Snapshot()) {
+        std::cout << "[HookStats] " << std::left << std::setw(32) << (s.enabled ? s.name : s.name + " (off)") << std::right
+            << std::setw(12) << s.calls << std::fixed << std::setprecision(1)
+            << std::setw(12) << s.hookP50 << std::setw(12) << s.hookP99
+            << std::setw(12) << s.originalP50 << std::setw(12) << s.originalP99 << "\n";
+    }
+    std::cout << std::defaultfloat;
+}
+
+void HookStats::Reset()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    // Racing increments from other threads may survive the reset; fine for statistics
+    for (Site* site : registry.sites) {
+        for (Shard& shard : site->shards) {
+            shard.calls.store(0, std::memory_order_relaxed);
+            for (size_t b = 0; b < kBuckets; ++b) {
+                shard.hook[b].store(0, std::memory_order_relaxed);
+                shard.original[b].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
@@ -0,0 +1,205 @@
+#include "HookTrace.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <new>
+
+std::atomic<bool>              HookTrace::recording{ false };
+std::atomic<HookTrace::Ring*>  HookTrace::rings{ nullptr };
+
+namespace
+{
+    HANDLE                g_thread = nullptr;
+    HANDLE                g_stopEvent = nullptr;
+    DWORD                 g_interval = 10;
+    FILE*                 g_file = nullptr;
+    bool                  g_first = true;
+    DWORD                 g_pid = 0;
+    uint64_t              g_tsc0 = 0;
+    double                g_ticksPerUs = 1.0;
+    std::atomic<uint64_t> g_written{ 0 };
+    std::atomic<uint64_t> g_lostRings{ 0 };   // events from threads whose ring could not be allocated
+
+    // TSC rate against QPC over a short busy window; invariant TSC is assumed (every x64 CPU since ~2008)
+    double CalibrateTicksPerUs()
+    {
+        LARGE_INTEGER frequency{}, q0{}, q1{};
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&q0);
+        const uint64_t t0 = __rdtsc();
+        do {
+            QueryPerformanceCounter(&q1);
+        } while (q1.QuadPart - q0.QuadPart < frequency.QuadPart / 50);   // 20 ms
+        const uint64_t t1 = __rdtsc();
+
+        const double us = double(q1.QuadPart - q0.QuadPart) * 1e6 / double(frequency.QuadPart);
+        return us > 0 ? double(t1 - t0) / us : 1.0;
+    }
+
+    void WriteName(const char* name)
+    {
+        for (const char* c = name; *c; ++c) {
+            if (*c == '"' || *c == '\\') fputc('\\', g_file);
+            if (static_cast<unsigned char>(*c) < 0x20) continue;
+            fputc(*c, g_file);
+        }
+    }
+}
+
+HookTrace::RingOwner::~RingOwner()
+{
+    if (ring) ring->owned.store(false, std::memory_order_release);
+    ring = nullptr;
+    exited = true;
+}
+
+HookTrace::Ring* HookTrace::CreateRing()
+{
+    if (threadRing.exited) return nullptr;
+
+    // Reuse a ring whose thread exited and whose events were all written; nobody else moves
+    // head of an unowned ring, so an empty one stays empty until claimed
+    for (Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        if (ring->owned.load(std::memory_order_relaxed)) continue;
+        if (ring->head.load(std::memory_order_relaxed) != ring->tail.load(std::memory_order_acquire)) continue;
+
+        bool expected = false;
+        if (ring->owned.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+            // published to the flusher by the release store of the next head
+            ring->threadId = GetCurrentThreadId();
+            threadRing.ring = ring;
+            return ring;
+        }
+    }
+
+    // VirtualAlloc rather than new so a hook on the CRT heap cannot recurse here
+    void* memory = VirtualAlloc(nullptr, sizeof(Ring), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory) {
+        g_lostRings.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Ring* ring = new (memory) Ring();
+    ring->threadId = GetCurrentThreadId();
+    ring->next = rings.load(std::memory_order_relaxed);
+    while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed)) {}
+
+    threadRing.ring = ring;
+    return ring;
+}
+
+size_t HookTrace::Drain(bool final)
+{
+    size_t count = 0;
+    for (Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        const uint32_t head = ring->head.load(std::memory_order_acquire);
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+
+        for (; tail != head; ++tail) {
+            const Event& event = ring->events[tail & (kRingSize - 1)];
+            if (event.tsc < g_tsc0) continue;   // recorded while Stop raced a hook on the previous run
+
+            fputs(g_first ? "\n" : ",\n", g_file);
+            g_first = false;
+            fputs("{\"name\":\"", g_file);
+            WriteName(event.name);
+            fprintf(g_file, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%lu,\"tid\":%lu%s}",
+                static_cast<char>(event.phase), double(event.tsc - g_tsc0) / g_ticksPerUs,
+                static_cast<unsigned long>(g_pid), static_cast<unsigned long>(ring->threadId),
+                event.phase == Phase::Instant ? ",\"s\":\"t\"" : "");
+            ++count;
+        }
+        // Hand the slots back only after the events are formatted
+        ring->tail.store(tail, std::memory_order_release);
+    }
+
+    g_written.fetch_add(count, std::memory_order_relaxed);
+    if (final || count) fflush(g_file);
+    return count;
+}
+
+DWORD WINAPI HookTrace::FlusherThread(LPVOID)
+{
+    while (WaitForSingleObject(g_stopEvent, g_interval) == WAIT_TIMEOUT) {
+        Drain(false);
+    }
+    Drain(true);
+    return 0;
+}
+
+bool HookTrace::Start(const std::string& path, DWORD flushIntervalMs)
+{
+    if (g_thread) return false;
+
+    if (fopen_s(&g_file, path.c_str(), "wb") != 0 || !g_file) {
+        std::cerr << "[HookTrace] Failed to open " << path << std::endl;
+        g_file = nullptr;
+        return false;
+    }
+    // Events are streamed as they are drained; a large buffer keeps that to a few writes per flush
+    setvbuf(g_file, nullptr, _IOFBF, 1 << 20);
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", g_file);
+
+    g_first = true;
+    g_pid = GetCurrentProcessId();
+    g_interval = (std::max)(flushIntervalMs, DWORD(1));
+    g_written = 0;
+    g_lostRings = 0;
+    g_ticksPerUs = CalibrateTicksPerUs();
+
+    // Discard whatever a previous run left behind
+    for (Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+        ring->dropped.store(0, std::memory_order_relaxed);
+    }
+
+    g_tsc0 = __rdtsc();
+    g_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (g_stopEvent) g_thread = CreateThread(nullptr, 0, FlusherThread, nullptr, 0, nullptr);
+    if (!g_thread) {
+        if (g_stopEvent) CloseHandle(g_stopEvent);
+        g_stopEvent = nullptr;
+        fclose(g_file);
+        g_file = nullptr;
+        return false;
+    }
+
+    recording.store(true, std::memory_order_release);
+    return true;
+}
+
+void HookTrace::Stop()
+{
+    recording.store(false, std::memory_order_release);
+    if (!g_thread) return;
+
+    SetEvent(g_stopEvent);
+    WaitForSingleObject(g_thread, INFINITE);
+    CloseHandle(g_thread);
+    CloseHandle(g_stopEvent);
+    g_thread = nullptr;
+    g_stopEvent = nullptr;
+
+    fputs("\n]}\n", g_file);
+    fclose(g_file);
+    g_file = nullptr;
+
+    const uint64_t dropped = GetDroppedEvents();
+    if (dropped) {
+        std::cout << "[HookTrace] " << dropped << " events dropped (ring full), raise the flush rate or kRingSize" << std::endl;
+    }
+}
+
+uint64_t HookTrace::GetWrittenEvents()
+{
+    return g_written.load();
+}
+
+uint64_t HookTrace::GetDroppedEvents()
+{
+    uint64_t dropped = g_lostRings.load();
+    for (Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
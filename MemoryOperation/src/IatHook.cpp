@@ -0,0 +1,72 @@
+#include "IatHook.h"
+#include <cstdlib>
+
+namespace
+{
+    bool EqualsNoCase(const char* a, const std::string& b)
+    {
+        return _stricmp(a, b.c_str()) == 0;
+    }
+}
+
+IatHook::IatHook(uintptr_t module, const std::string& importModule, const std::string& function, uintptr_t replacement)
+{
+    const uintptr_t slot = FindSlot(module, importModule, function);
+    if (!slot) {
+        throw std::runtime_error("IatHook: " + importModule + "!" + function + " is not imported");
+    }
+    Init(slot, replacement);
+}
+
+uintptr_t IatHook::FindSlot(uintptr_t module, const std::string& importModule, const std::string& function)
+{
+    if (!module) module = Memory::GetBaseAddress();
+    if (!module || importModule.empty() || function.empty()) return 0;
+
+    if (Memory::IsBadRange(module, sizeof(IMAGE_DOS_HEADER), false)) return 0;
+    auto dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(module);
+    if (dos->e_magic != IMAGE_DOS_SIGNATURE) return 0;
+
+    auto nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(module + dos->e_lfanew);
+    if (Memory::IsBadRange(reinterpret_cast<uintptr_t>(nt), sizeof(IMAGE_NT_HEADERS), false)) return 0;
+    if (nt->Signature != IMAGE_NT_SIGNATURE) return 0;
+
+    const IMAGE_DATA_DIRECTORY& dir = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+    if (!dir.VirtualAddress || !dir.Size) return 0;
+
+    const bool byOrdinal = function[0] == '#';
+    const ULONG_PTR ordinal = byOrdinal ? std::strtoul(function.c_str() + 1, nullptr, 10) : 0;
+
+    auto desc = reinterpret_cast<const IMAGE_IMPORT_DESCRIPTOR*>(module + dir.VirtualAddress);
+    for (; desc->Name; ++desc) {
+        if (!EqualsNoCase(reinterpret_cast<const char*>(module + desc->Name), importModule)) continue;
+
+        auto iat = reinterpret_cast<IMAGE_THUNK_DATA*>(module + desc->FirstThunk);
+
+        // The lookup table keeps names after binding; without it fall back to the resolved address
+        if (desc->OriginalFirstThunk) {
+            auto names = reinterpret_cast<const IMAGE_THUNK_DATA*>(module + desc->OriginalFirstThunk);
+            for (size_t i = 0; names[i].u1.AddressOfData; ++i) {
+                if (IMAGE_SNAP_BY_ORDINAL(names[i].u1.Ordinal)) {
+                    if (byOrdinal && (names[i].u1.Ordinal & 0xFFFF) == ordinal)
+                        return reinterpret_cast<uintptr_t>(&iat[i].u1.Function);
+                    continue;
+                }
+                if (byOrdinal) continue;
+
+                auto byName = reinterpret_cast<const IMAGE_IMPORT_BY_NAME*>(module + names[i].u1.AddressOfData);
+                if (function == byName->Name)
+                    return reinterpret_cast<uintptr_t>(&iat[i].u1.Function);
+            }
+        }
+        else if (HMODULE dll = GetModuleHandleA(importModule.c_str())) {
+            const FARPROC target = byOrdinal ? GetProcAddress(dll, reinterpret_cast<LPCSTR>(ordinal))
+                                             : GetProcAddress(dll, function.c_str());
+            for (size_t i = 0; target && iat[i].u1.Function; ++i) {
+                if (iat[i].u1.Function == reinterpret_cast<ULONG_PTR>(target))
+                    return reinterpret_cast<uintptr_t>(&iat[i].u1.Function);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "InlineHook.h"
+#include "CodeAllocator.h"
+#include "CodePatcher.h"
+#include "CodeRelocator.h"
+#include "ToggleStub.h"
+#include <cstring>
+
+namespace
+{
+    constexpr size_t kRelaySize = 16;
+}
+
+InlineHook::InlineHook(uintptr_t target, uintptr_t detour, bool softToggle)
+{
+    if (!target || !detour) {
+        throw std::invalid_argument("InlineHook: null target or detour");
+    }
+
+    // longest instruction plus the jump we overwrite with
+    if (Memory::IsBadRange(target, kJumpSize + 15, false)) {
+        throw std::runtime_error("InlineHook: target is not readable");
+    }
+
+    uint8_t* block = CodeAllocator::Allocate(CodeRelocator::kMaxTrampolineSize + kRelaySize, target);
+    if (!block) {
+        throw std::runtime_error("InlineHook: no executable memory near the target");
+    }
+
+    size_t stolen = 0;
+    const uintptr_t blockAddress = reinterpret_cast<uintptr_t>(block);
+    if (!CodeRelocator::Relocate(target, kJumpSize, block, CodeRelocator::kMaxTrampolineSize, blockAddress, &stolen)) {
+        throw std::runtime_error("InlineHook: target prologue cannot be relocated");
+    }
+
+    // The jmp at the target is rel32, so a far detour is reached through a relay in the same block.
+    // A soft-toggled hook jumps to its toggle stub instead, which reaches anything.
+    uintptr_t jumpTo = detour;
+    if (softToggle) {
+        toggle = ToggleStub::Allocate(target);
+        if (!toggle || !ToggleStub::Emit(toggle, detour, blockAddress, true)) {
+            throw std::runtime_error("InlineHook: no executable memory near the target for the toggle stub");
+        }
+        FlushInstructionCache(GetCurrentProcess(), toggle, ToggleStub::kSize);
+        jumpTo = ToggleStub::Entry(toggle);
+    }
+    else if (!CodeRelocator::InRel32(target + kJumpSize, detour)) {
+        const uintptr_t relay = blockAddress + CodeRelocator::kMaxTrampolineSize;
+        if (!CodeRelocator::EmitJump(block + CodeRelocator::kMaxTrampolineSize, relay, detour)) {
+            throw std::runtime_error("InlineHook: detour is out of reach");
+        }
+        jumpTo = relay;
+    }
+    FlushInstructionCache(GetCurrentProcess(), block, CodeRelocator::kMaxTrampolineSize + kRelaySize);
+
+    jump[0] = 0xE9;
+    const int32_t rel = static_cast<int32_t>(static_cast<intptr_t>(jumpTo - (target + kJumpSize)));
+    std::memcpy(jump + 1, &rel, sizeof(rel));
+
+    address = target;
+    size = stolen;
+    original_bytes = Memory::ReadBytes(target, stolen);
+    trampoline = block;
+    detourAddress = detour;
+}
+
+InlineHook::~InlineHook()
+{
+    // The trampoline stays allocated: another thread may still be running through it
+    if (is_modified) {
+        try { Restore(); }
+        catch (...) {}
+    }
+}
+
+bool InlineHook::Apply()
+{
+    if (is_modified) {
+        std::cout << "Inline hook already applied\n";
+        return true;
+    }
+
+    // Somebody else rewrote the prologue since we relocated it
+    if (Memory::ReadBytes(address, size) != original_bytes) {
+        std::cerr << "[InlineHook] Apply failed: target bytes changed at 0x" << std::hex << address << std::dec << "\n";
+        return false;
+    }
+
+    if (!CodePatcher::Write(address, jump, kJumpSize)) {
+        std::cerr << "[InlineHook] Apply failed: cannot write at 0x" << std::hex << address << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = true;
+    return true;
+}
+
+bool InlineHook::Restore()
+{
+    if (!is_modified) {
+        return true;
+    }
+
+    if (Memory::IsBadRange(address, kJumpSize, false)) {
+        std::cout << "Restore: target memory invalid, skipping\n";
+        is_modified = false;
+        return true;
+    }
+
+    // only the jump was written, the rest of the stolen bytes are untouched
+    if (!CodePatcher::Write(address, original_bytes.data(), kJumpSize)) {
+        std::cerr << "[InlineHook] Restore failed: cannot write at 0x" << std::hex << address << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = false;
+    return true;
+}
+
+bool InlineHook::SetEnabled(bool enabled)
+{
+    if (!toggle) return enabled ? Apply() : Restore();
+
+    if (enabled && !is_modified && !Apply()) return false;
+    ToggleStub::SetEnabled(toggle, enabled);
+    return true;
+}
+
+bool InlineHook::IsEnabled() const
+{
+    return is_modified && (!toggle || ToggleStub::IsEnabled(toggle));
+}
@@ -0,0 +1,288 @@
+#include "InstructionDecoder.h"
+#include <cstring>
+
+namespace
+{
+    // Operand flags per opcode
+    constexpr uint8_t M  = 0x01;   // ModRM follows
+    constexpr uint8_t B  = 0x02;   // imm8
+    constexpr uint8_t Z  = 0x04;   // imm16/32 (operand size)
+    constexpr uint8_t W  = 0x08;   // imm16
+    constexpr uint8_t R8 = 0x10;   // rel8
+    constexpr uint8_t RZ = 0x20;   // rel16/32
+    constexpr uint8_t P  = 0x40;   // legacy prefix
+    constexpr uint8_t X  = 0x80;   // needs special handling
+    constexpr uint8_t MB = M | B, MZ = M | Z, WB = W | B, MX = M | X;
+
+    constexpr uint8_t kOneByte[256] = {
+         M,  M,  M,  M,  B,  Z,  0,  0,  M,  M,  M,  M,  B,  Z,  0,  X,  // 00
+         M,  M,  M,  M,  B,  Z,  0,  0,  M,  M,  M,  M,  B,  Z,  0,  0,  // 10
+         M,  M,  M,  M,  B,  Z,  P,  0,  M,  M,  M,  M,  B,  Z,  P,  0,  // 20
+         M,  M,  M,  M,  B,  Z,  P,  0,  M,  M,  M,  M,  B,  Z,  P,  0,  // 30
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 40
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  // 50
+         0,  0,  X,  M,  P,  P,  P,  P,  Z, MZ,  B, MB,  0,  0,  0,  0,  // 60
+        R8, R8, R8, R8, R8, R8, R8, R8, R8, R8, R8, R8, R8, R8, R8, R8,  // 70
+        MB, MZ, MB, MB,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  X,  // 80
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  X,  0,  0,  0,  0,  0,  // 90
+         X,  X,  X,  X,  0,  0,  0,  0,  B,  Z,  0,  0,  0,  0,  0,  0,  // A0
+         B,  B,  B,  B,  B,  B,  B,  B,  X,  X,  X,  X,  X,  X,  X,  X,  // B0
+        MB, MB,  W,  0,  X,  X, MB, MZ, WB,  0,  W,  0,  0,  B,  0,  0,  // C0
+         M,  M,  M,  M,  B,  B,  0,  0,  M,  M,  M,  M,  M,  M,  M,  M,  // D0
+        R8, R8, R8, R8,  B,  B,  B,  B, RZ, RZ,  X, R8,  0,  0,  0,  0,  // E0
+         P,  0,  P,  P,  0,  0, MX, MX,  0,  0,  0,  0,  0,  0,  M,  M,  // F0
+    };
+
+    constexpr uint8_t kTwoByte[256] = {
+         M,  M,  M,  M,  0,  0,  0,  0,  0,  0,  0,  0,  0,  M,  0, MB,  // 00
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // 10
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // 20
+         0,  0,  0,  0,  0,  0,  0,  0,  X,  0,  X,  0,  0,  0,  0,  0,  // 30
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // 40
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // 50
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // 60
+        MB, MB, MB, MB,  M,  M,  M,  0,  M,  M,  0,  0,  M,  M,  M,  M,  // 70
+        RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ, RZ,  // 80
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // 90
+         0,  0,  0,  M, MB,  M,  M,  M,  0,  0,  0,  M, MB,  M,  M,  M,  // A0
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M, MB,  M,  M,  M,  M,  M,  // B0
+         M,  M, MB,  M, MB, MB, MB,  M,  0,  0,  0,  0,  0,  0,  0,  0,  // C0
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // D0
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // E0
+         M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  M,  // F0
+    };
+
+    // Flags for an opcode in one of the escape maps (0F, 0F38, 0F3A)
+    uint8_t MapFlags(uint8_t map, uint8_t opcode)
+    {
+        switch (map) {
+        case 1:  return kTwoByte[opcode];
+        case 3:  return MB;
+        default: return M;
+        }
+    }
+
+    DecodedInstruction::Flow ClassifyFlow(const DecodedInstruction& in)
+    {
+        using Flow = DecodedInstruction::Flow;
+        const uint8_t op = in.opcode;
+
+        if (in.opcodeMap == 1) {
+            if (op >= 0x80 && op <= 0x8F) return Flow::CondJump;
+            if (op == 0x0B) return Flow::Interrupt;   // UD2
+            return Flow::None;
+        }
+        if (in.opcodeMap != 0) return Flow::None;
+
+        if ((op >= 0x70 && op <= 0x7F) || (op >= 0xE0 && op <= 0xE3)) return Flow::CondJump;
+
+        switch (op) {
+        case 0xE8: return Flow::Call;
+        case 0xE9: case 0xEB: return Flow::Jump;
+        case 0xC2: case 0xC3: case 0xCA: case 0xCB: case 0xCF: return Flow::Return;
+        case 0xCC: case 0xCD: return Flow::Interrupt;
+        case 0xFF:
+            switch (in.ModrmReg()) {
+            case 2: case 3: return Flow::IndirectCall;
+            case 4: case 5: return Flow::IndirectJump;
+            }
+            break;
+        }
+        return Flow::None;
+    }
+
+    int64_t ReadSigned(const uint8_t* p, size_t size)
+    {
+        switch (size) {
+        case 1: return static_cast<int8_t>(p[0]);
+        case 2: { int16_t v; std::memcpy(&v, p, 2); return v; }
+        case 4: { int32_t v; std::memcpy(&v, p, 4); return v; }
+        default: return 0;
+        }
+    }
+}
+
+uintptr_t DecodedInstruction::BranchTarget(uintptr_t address, const uint8_t* code) const
+{
+    if (!relSize) return 0;
+    return address + length + static_cast<intptr_t>(ReadSigned(code + immOffset, relSize));
+}
+
+uintptr_t DecodedInstruction::RipTarget(uintptr_t address, const uint8_t* code) const
+{
+    if (!ripRelative) return 0;
+    return address + length + static_cast<intptr_t>(ReadSigned(code + dispOffset, dispSize));
+}
+
+bool InstructionDecoder::Decode(const uint8_t* code, size_t available, DecodedInstruction& out, bool x64)
+{
+    out = DecodedInstruction{};
+    if (!code || !available) return false;
+
+    const size_t limit = available < 15 ? available : 15;
+    size_t pos = 0;
+    bool opsize16 = false;
+    bool addrOverride = false;
+
+    // legacy prefixes, then REX (which must come last to count)
+    for (;; ++pos) {
+        if (pos >= limit) return false;
+        const uint8_t b = code[pos];
+        if (kOneByte[b] & P) {
+            if (b == 0x66) opsize16 = true;
+            if (b == 0x67) addrOverride = true;
+            out.rex = 0;
+            continue;
+        }
+        if (x64 && (b & 0xF0) == 0x40) {
+            out.rex = b;
+            continue;
+        }
+        break;
+    }
+
+    const bool rexW = (out.rex & 0x08) != 0;
+    uint8_t op = code[pos++];
+    uint8_t flags = kOneByte[op];
+    uint8_t map = 0;
+
+    auto peekModIs11 = [&] { return pos < limit && (code[pos] & 0xC0) == 0xC0; };
+
+    if (op == 0x0F) {
+        if (pos >= limit) return false;
+        op = code[pos++];
+        map = 1;
+        if (op == 0x38 || op == 0x3A) {
+            if (pos >= limit) return false;
+            map = op == 0x38 ? 2 : 3;
+            op = code[pos++];
+        }
+        flags = MapFlags(map, op);
+    }
+    else if ((op == 0xC4 || op == 0xC5) && (x64 || peekModIs11())) {
+        // VEX: C5 has one payload byte and implies map 0F, C4 has two and encodes the map
+        const size_t payload = op == 0xC5 ? 1 : 2;
+        if (pos + payload >= limit) return false;
+        map = op == 0xC5 ? 1 : (code[pos] & 0x1F);
+        pos += payload;
+        op = code[pos++];
+        flags = (map == 1 && op == 0x77) ? 0 : (MapFlags(map, op) | M);   // vzeroupper/vzeroall have no ModRM
+        flags &= ~RZ;
+    }
+    else if (op == 0x62 && (x64 || peekModIs11())) {
+        // EVEX: three payload bytes, map in the low bits of the first
+        if (pos + 3 >= limit) return false;
+        map = code[pos] & 0x07;
+        pos += 3;
+        op = code[pos++];
+        flags = (MapFlags(map, op) | M) & ~RZ;
+    }
+    else if (op == 0x8F && pos < limit && (code[pos] & 0x1F) >= 8) {
+        // AMD XOP: map 8 carries imm8, map 10 imm32
+        if (pos + 2 >= limit) return false;
+        map = code[pos] & 0x1F;
+        pos += 2;
+        op = code[pos++];
+        flags = map == 8 ? MB : M;
+        if (map == 10) flags |= Z;
+    }
+    else if (op == 0x62 || op == 0xC4 || op == 0xC5 || op == 0x8F) {
+        flags = M;   // BOUND / LES / LDS / POP r/m
+    }
+
+    out.opcode = op;
+    out.opcodeMap = map;
+    out.opcodeOffset = static_cast<uint8_t>(pos - 1);
+
+    // ModRM, SIB and displacement
+    if (flags & M) {
+        if (pos >= limit) return false;
+        out.hasModrm = true;
+        out.modrm = code[pos++];
+
+        // MOV to/from control, debug and test registers ignore the mod bits
+        const bool regOnly = map == 1 && op >= 0x20 && op <= 0x27;
+        const uint8_t mod = regOnly ? 3 : out.modrm >> 6;
+        const uint8_t rm = out.modrm & 7;
+        const bool addr16 = !x64 && addrOverride;
+        uint8_t disp = 0;
+
+        if (mod != 3) {
+            if (addr16) {
+                if (mod == 0 && rm == 6) disp = 2;
+                else if (mod == 1) disp = 1;
+                else if (mod == 2) disp = 2;
+            }
+            else {
+                if (rm == 4) {
+                    if (pos >= limit) return false;
+                    const uint8_t sib = code[pos++];
+                    if (mod == 0 && (sib & 7) == 5) disp = 4;
+                }
+                if (mod == 0 && rm == 5) {
+                    disp = 4;
+                    out.ripRelative = x64;
+                }
+                else if (mod == 1) disp = 1;
+                else if (mod == 2) disp = 4;
+            }
+        }
+
+        out.dispOffset = static_cast<uint8_t>(pos);
+        out.dispSize = disp;
+        pos += disp;
+    }
+
+    // Immediate / relative operand
+    uint8_t imm = 0;
+    const uint8_t immZ = opsize16 ? 2 : 4;
+
+    if (flags & B) imm += 1;
+    if (flags & W) imm += 2;
+    if (flags & Z) imm += immZ;
+    if (flags & R8) {
+        imm = 1;
+        out.relSize = 1;
+    }
+    if (flags & RZ) {
+        imm = (x64 || !opsize16) ? 4 : 2;
+        out.relSize = imm;
+    }
+
+    if ((flags & X) && map == 0) {
+        if (op == 0xF6 || op == 0xF7) {
+            if (out.ModrmReg() < 2) imm = op == 0xF6 ? 1 : immZ;    // TEST r/m, imm
+        }
+        else if (op >= 0xA0 && op <= 0xA3) {
+            imm = x64 ? (addrOverride ? 4 : 8) : (addrOverride ? 2 : 4);   // MOV moffs
+        }
+        else if (op >= 0xB8 && op <= 0xBF) {
+            imm = (x64 && rexW) ? 8 : immZ;    // MOV r, imm (imm64 with REX.W)
+        }
+        else if (op == 0x9A || op == 0xEA) {
+            if (x64) return false;             // far call/jmp ptr16:32 is invalid in long mode
+            imm = immZ + 2;
+        }
+    }
+
+    out.immOffset = static_cast<uint8_t>(pos);
+    out.immSize = imm;
+    pos += imm;
+
+    if (pos > limit) return false;
+
+    out.length = static_cast<uint8_t>(pos);
+    out.flow = ClassifyFlow(out);
+    return true;
+}
+
+size_t InstructionDecoder::CoverLength(const uint8_t* code, size_t minLength, bool x64)
+{
+    size_t length = 0;
+    while (length < minLength) {
+        DecodedInstruction in;
+        if (!Decode(code + length, 15, in, x64)) return 0;
+        length += in.length;
+    }
+    return length;
+}
@@ -0,0 +1,206 @@
+#include "IntegrityMonitor.h"
+#include "MemoryOperator.h"
+#include <array>
+#include <cstring>
+#include <intrin.h>
+#include <unordered_set>
+
+std::vector<IntegrityMonitor::Entry> IntegrityMonitor::entries;
+size_t IntegrityMonitor::cursor = 0;
+IntegrityMonitor::DriftCallback IntegrityMonitor::callback = nullptr;
+
+namespace
+{
+    // Reflected Castagnoli polynomial, same result as the SSE4.2 crc32 instruction
+    constexpr std::array<uint32_t, 256> MakeCrc32cTable()
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : (c >> 1);
+            table[i] = c;
+        }
+        return table;
+    }
+
+    constexpr auto kCrc32cTable = MakeCrc32cTable();
+
+    bool HasSse42()
+    {
+        static const bool supported = [] {
+            int regs[4]{};
+            __cpuid(regs, 1);
+            return (regs[2] & (1 << 20)) != 0;
+        }();
+        return supported;
+    }
+
+    uint32_t Crc32cSoftware(const uint8_t* p, size_t size, uint32_t crc)
+    {
+        while (size--)
+            crc = kCrc32cTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    uint32_t Crc32cHardware(const uint8_t* p, size_t size, uint32_t crc)
+    {
+#ifdef _WIN64
+        uint64_t crc64 = crc;
+        for (; size >= 8; size -= 8, p += 8) {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            crc64 = _mm_crc32_u64(crc64, v);
+        }
+        crc = static_cast<uint32_t>(crc64);
+#endif
+        for (; size >= 4; size -= 4, p += 4) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            crc = _mm_crc32_u32(crc, v);
+        }
+        while (size--)
+            crc = _mm_crc32_u8(crc, *p++);
+        return crc;
+    }
+
+    int64_t Now()
+    {
+        LARGE_INTEGER t;
+        QueryPerformanceCounter(&t);
+        return t.QuadPart;
+    }
+
+    int64_t TicksPerMicrosecond()
+    {
+        static const int64_t ticks = [] {
+            LARGE_INTEGER f;
+            QueryPerformanceFrequency(&f);
+            return f.QuadPart / 1000000 ? f.QuadPart / 1000000 : 1;
+        }();
+        return ticks;
+    }
+}
+
+uint32_t IntegrityMonitor::Crc32c(const void* data, size_t size, uint32_t crc)
+{
+    auto p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    crc = HasSse42() ? Crc32cHardware(p, size, crc) : Crc32cSoftware(p, size, crc);
+    return ~crc;
+}
+
+// Kept free of C++ objects so it can use SEH: the host may unmap a range under us.
+bool IntegrityMonitor::HashLive(uintptr_t address, size_t size, uint32_t* hash)
+{
+    __try {
+        *hash = Crc32c(reinterpret_cast<const void*>(address), size);
+        return true;
+    }
+    __except (EXCEPTION_EXECUTE_HANDLER) {
+        return false;
+    }
+}
+
+void IntegrityMonitor::SetCallback(DriftCallback cb)
+{
+    callback = cb;
+}
+
+bool IntegrityMonitor::MakeEntry(const std::string& name, const std::shared_ptr<MemoryOperation>& op, Entry& entry)
+{
+    if (!op || !op->is_modified || !op->address || !op->size) return false;
+
+    entry = Entry{ name, op, op->address, op->size };
+
+    if (auto patch = dynamic_cast<Patch*>(op.get()))
+        entry.hash = Crc32c(patch->new_bytes.data(), patch->new_bytes.size());
+    else if (!HashLive(entry.address, entry.size, &entry.hash))
+        return false;
+
+    return true;
+}
+
+bool IntegrityMonitor::Track(const std::string& name, const std::shared_ptr<MemoryOperation>& op)
+{
+    Entry entry;
+    if (!MakeEntry(name, op, entry)) return false;
+
+    for (auto& e : entries) {
+        if (e.name == name) {
+            e = std::move(entry);
+            return true;
+        }
+    }
+    entries.push_back(std::move(entry));
+    return true;
+}
+
+void IntegrityMonitor::Untrack(const std::string& name)
+{
+    std::erase_if(entries, [&](const Entry& e) { return e.name == name; });
+    if (cursor >= entries.size()) cursor = 0;
+}
+
+size_t IntegrityMonitor::Sync()
+{
+    std::lock_guard lock(MemoryOperator::GetOperationsMutex());
+    auto& ops = MemoryOperator::GetOperations();
+
+    // drop entries whose operation was restored, erased or replaced
+    std::erase_if(entries, [&](const Entry& e) {
+        auto op = e.op.lock();
+        auto it = ops.find(e.name);
+        return !op || !op->is_modified || it == ops.end() || it->second != op;
+    });
+
+    // reserve up front so the views into entries stay valid while appending
+    entries.reserve(ops.size());
+    std::unordered_set<std::string_view> tracked;
+    tracked.reserve(entries.size());
+    for (const auto& e : entries) tracked.emplace(e.name);
+
+    for (const auto& [name, op] : ops) {
+        Entry entry;
+        if (!tracked.contains(name) && MakeEntry(name, op, entry))
+            entries.push_back(std::move(entry));
+    }
+
+    if (cursor >= entries.size()) cursor = 0;
+    return entries.size();
+}
+
+size_t IntegrityMonitor::Tick(uint32_t budgetMicroseconds)
+{
+    if (entries.empty()) return 0;
+
+    const int64_t deadline = Now() + static_cast<int64_t>(budgetMicroseconds) * TicksPerMicrosecond();
+    size_t checked = 0;
+
+    while (checked < entries.size()) {
+        // reading the clock costs more than hashing a short patch, so only poll it every few entries
+        if ((checked & 15) == 0 && checked && Now() >= deadline) break;
+
+        Entry& e = entries[cursor];
+        cursor = (cursor + 1) % entries.size();
+        ++checked;
+
+        auto op = e.op.lock();
+        if (!op || !op->is_modified) continue;
+
+        uint32_t live = 0;
+        const bool drift = !HashLive(e.address, e.size, &live) || live != e.hash;
+
+        if (drift && !e.drifted && callback)
+            callback(e.name, op.get());
+        e.drifted = drift;
+    }
+
+    return checked;
+}
+
+void IntegrityMonitor::Clear()
+{
+    entries.clear();
+    cursor = 0;
+}
@@ -17,6 +17,12 @@ std::vector<unsigned char> Memory::ReadBytes(uintptr_t address, size_t size)
     return result;
 }
 
+bool Memory::ReadRaw(uintptr_t address, void* out, size_t size)
+{
+    SIZE_T read = 0;
+    return ReadProcessMemory(GetCurrentProcess(), reinterpret_cast<LPCVOID>(address), out, size, &read) && read == size;
+}
+
 // 3. Read ASCII string using ReadBytes
 std::string Memory::ReadAscii(uintptr_t address, size_t max_length)
 {
@@ -64,6 +70,22 @@ uintptr_t Memory::GetModuleAddress(std::string ModuleName)
     return NULL;
 }
 
+size_t Memory::GetModuleSize(uintptr_t moduleBase)
+{
+    if (!moduleBase || IsBadRange(moduleBase, sizeof(IMAGE_DOS_HEADER), false)) return 0;
+
+    auto dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(moduleBase);
+    if (dos->e_magic != IMAGE_DOS_SIGNATURE) return 0;
+
+    const uintptr_t ntAddr = moduleBase + dos->e_lfanew;
+    if (IsBadRange(ntAddr, sizeof(IMAGE_NT_HEADERS), false)) return 0;
+
+    auto nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(ntAddr);
+    if (nt->Signature != IMAGE_NT_SIGNATURE) return 0;
+
+    return nt->OptionalHeader.SizeOfImage;
+}
+
 std::string Memory::BytesToString(const std::vector<uint8_t>& bytes, std::size_t len) {
     const std::size_t n = (std::min)(len, bytes.size());
     if (n == 0) return {};
@@ -6,6 +6,12 @@ bool MemoryOperator::DEBUG = false;
 
 std::map<std::string, std::shared_ptr<MemoryOperation>> MemoryOperator::operations;
 std::map<std::string, std::shared_ptr<MemoryOperation>> MemoryOperator::Savedoperations;
+std::atomic<uint64_t> MemoryOperator::revision{ 0 };
+bool MemoryOperator::hookTransactionOpen = false;
+std::vector<std::string> MemoryOperator::queuedHooks;
+std::map<std::string, std::vector<MemoryOperator::PendingOperation>> MemoryOperator::pendingOperations;
+std::mutex MemoryOperator::pendingMutex;
+std::recursive_mutex MemoryOperator::operationsMutex;
 
 // header:
 // Patch* CreatePatch(const std::string& name, uintptr_t address, const std::vector<byte>& bytes);
@@ -14,6 +20,7 @@ Patch* MemoryOperator::CreatePatch(const std::string& name,
     uintptr_t address,
     const std::vector<byte>& bytes)
 {
+    std::lock_guard lock(operationsMutex);
     auto& ops = operations;
 
     if (ops.find(name) != ops.end()) return nullptr;          // name exists
@@ -24,6 +31,7 @@ Patch* MemoryOperator::CreatePatch(const std::string& name,
         auto patch = std::make_shared<Patch>(address, bytes);  // shared_ptr
         Patch* raw = patch.get();                              // do NOT delete
         ops.emplace(name, std::static_pointer_cast<MemoryOperation>(std::move(patch)));
+        ++revision;
         return raw;
     }
     catch (...) {
@@ -38,8 +46,10 @@ Patch* MemoryOperator::CreatePatch(const std::string& name,
 WinDetour* MemoryOperator::CreateDetour(const std::string& name,
     uintptr_t target_addr,
     uintptr_t detour_addr,
-    bool overrideExisting) 
+    bool overrideExisting,
+    bool softToggle) 
 {
+    std::lock_guard lock(operationsMutex);
     auto& ops = operations;
 
     // name clash handling
@@ -48,18 +58,21 @@ WinDetour* MemoryOperator::CreateDetour(const std::string& name,
             return nullptr;
         }
         ops.erase(name);
+        ++revision;
     }
 
     try 
     {
         auto detour = std::make_shared<WinDetour>(
             reinterpret_cast<PVOID*>(target_addr),
-            reinterpret_cast<PVOID>(detour_addr)
+            reinterpret_cast<PVOID>(detour_addr),
+            softToggle
         );
 
         WinDetour* raw = detour.get();
         ops.emplace(name, std::move(detour));
-       
+        ++revision;
+
         return raw;
     }
     catch (const std::exception& e) {
@@ -73,8 +86,287 @@ WinDetour* MemoryOperator::CreateDetour(const std::string& name,
 }
 
 
+InlineHook* MemoryOperator::CreateInlineHook(const std::string& name,
+    uintptr_t target_addr,
+    uintptr_t detour_addr,
+    bool overrideExisting,
+    bool softToggle)
+{
+    return Emplace<InlineHook>(name, overrideExisting, target_addr, detour_addr, softToggle);
+}
+
+bool MemoryOperator::SetHookEnabled(const std::string& name, bool enabled)
+{
+    if (WinDetour* detour = FindDetour(name)) return detour->SetEnabled(enabled);
+    if (InlineHook* hook = FindInlineHook(name)) return hook->SetEnabled(enabled);
+    return false;
+}
+
+MidHook* MemoryOperator::CreateMidHook(const std::string& name,
+    uintptr_t address,
+    MidHook::Callback callback,
+    bool overrideExisting)
+{
+    return Emplace<MidHook>(name, overrideExisting, address, callback);
+}
+
+IatHook* MemoryOperator::CreateIatHook(const std::string& name,
+    uintptr_t module,
+    const std::string& importModule,
+    const std::string& function,
+    uintptr_t replacement,
+    bool overrideExisting)
+{
+    return Emplace<IatHook>(name, overrideExisting, module, importModule, function, replacement);
+}
+
+VTableHook* MemoryOperator::CreateVTableHook(const std::string& name,
+    uintptr_t vtable,
+    size_t index,
+    uintptr_t replacement,
+    bool overrideExisting)
+{
+    return Emplace<VTableHook>(name, overrideExisting, vtable, index, replacement);
+}
+
+VTableInstanceHook* MemoryOperator::CreateVTableInstanceHook(const std::string& name,
+    uintptr_t object,
+    const std::vector<std::pair<size_t, uintptr_t>>& methods,
+    bool overrideExisting)
+{
+    VTableInstanceHook* hook = Emplace<VTableInstanceHook>(name, overrideExisting, object, size_t(0));
+    if (!hook) return nullptr;
+
+    for (const auto& [index, replacement] : methods) {
+        if (!hook->HookMethod(index, replacement))
+            std::cerr << "CreateVTableInstanceHook: '" << name << "' has no method " << index << "\n";
+    }
+    return hook;
+}
+
+
+bool MemoryOperator::CreateModulePatch(const std::string& name,
+    const ModuleTarget& target,
+    const std::vector<byte>& bytes)
+{
+    if (bytes.empty()) return false;
+    return QueuePending(PendingOperation{ name, target, bytes });
+}
+
+bool MemoryOperator::CreateModuleDetour(const std::string& name,
+    const ModuleTarget& target,
+    void** original,
+    uintptr_t detour_addr)
+{
+    if (!original || !detour_addr) return false;
+    return QueuePending(PendingOperation{ name, target, {}, original, detour_addr });
+}
+
+bool MemoryOperator::QueuePending(PendingOperation&& op)
+{
+    if (op.name.empty() || op.target.module.empty()) return false;
+    {
+        std::lock_guard lock(operationsMutex);
+        if (operations.contains(op.name)) return false;
+    }
+
+    const std::string module = ModuleWatcher::NormalizeName(op.target.module);
+    {
+        std::lock_guard lock(pendingMutex);
+        auto& list = pendingOperations[module];
+        if (std::ranges::any_of(list, [&](const auto& p) { return p.name == op.name; }))
+            return false;
+        list.push_back(std::move(op));
+    }
+
+    if (!ModuleWatcher::Install() && DEBUG)
+        std::cout << "[MemoryOperator] Loader notification unavailable, use ModuleWatcher::Poll()\n";
+
+    // Already mapped: no notification will come. The worker resolves it, so a caller in
+    // DllMain does not scan and suspend threads under the loader lock; without a worker
+    // resolve now. Checked outside pendingMutex, GetModuleHandle takes the loader lock.
+    if (HMODULE h = ::GetModuleHandleA(module.c_str())) {
+        const auto base = reinterpret_cast<uintptr_t>(h);
+        if (!ModuleWatcher::Enqueue(module, base)) ResolvePending(module, base);
+    }
+
+    return true;
+}
+
+size_t MemoryOperator::ResolvePending(const std::string& module, uintptr_t moduleBase)
+{
+    std::vector<PendingOperation> batch;
+    {
+        std::lock_guard lock(pendingMutex);
+        auto it = pendingOperations.find(module);
+        if (it == pendingOperations.end()) return 0;
+        batch = std::move(it->second);
+        pendingOperations.erase(it);
+    }
+
+    // Patches go in as they resolve, detours are attached together in one transaction
+    std::lock_guard lock(operationsMutex);
+    size_t applied = 0;
+    std::vector<std::string> detours;
+    for (auto& op : batch) {
+        const uintptr_t address = op.target.Resolve(moduleBase);
+        if (!address) {
+            std::cerr << "ResolvePending: could not resolve '" << op.name << "' in " << module << "\n";
+            continue;
+        }
+
+        if (op.original) {
+            *op.original = reinterpret_cast<void*>(address);
+            if (CreateDetour(op.name, reinterpret_cast<uintptr_t>(op.original), op.detour, true))
+                detours.push_back(op.name);
+        }
+        else if (Patch* patch = CreatePatch(op.name, address, op.bytes)) {
+            if (patch->Apply()) ++applied;
+        }
+    }
+
+    for (const auto& result : ApplyDetours(detours)) {
+        if (result.Succeeded()) ++applied;
+        else std::cerr << "ResolvePending: detour '" << result.name << "' failed (rc=" << result.error << ")\n";
+    }
+
+    if (DEBUG)
+        std::cout << "[MemoryOperator] " << module << " loaded, applied " << applied << "/" << batch.size() << " pending operations\n";
+
+    return applied;
+}
+
+std::vector<std::string> MemoryOperator::GetPendingModules()
+{
+    std::lock_guard lock(pendingMutex);
+    std::vector<std::string> modules;
+    modules.reserve(pendingOperations.size());
+    for (const auto& [module, list] : pendingOperations) modules.push_back(module);
+    return modules;
+}
+
+size_t MemoryOperator::GetPendingCount()
+{
+    std::lock_guard lock(pendingMutex);
+    size_t count = 0;
+    for (const auto& [module, list] : pendingOperations) count += list.size();
+    return count;
+}
+
+
+std::vector<MemoryOperator::HookResult> MemoryOperator::ApplyOperations(const std::vector<std::string>& names)
+{
+    return CommitOperations(names, true);
+}
+
+std::vector<MemoryOperator::HookResult> MemoryOperator::RestoreOperations(const std::vector<std::string>& names)
+{
+    return CommitOperations(names, false);
+}
+
+std::vector<MemoryOperator::HookResult> MemoryOperator::CommitOperations(const std::vector<std::string>& names, bool apply)
+{
+    std::lock_guard lock(operationsMutex);
+    std::vector<HookResult> results;
+    results.reserve(names.size());
+
+    // Detours go through one transaction, everything else changes on its own
+    std::vector<std::string> detours;
+    std::vector<size_t>      slots;
+    for (const auto& name : names) {
+        results.push_back(HookResult{ name });
+
+        auto it = operations.find(name);
+        if (it == operations.end() || !it->second) {
+            results.back().error = ERROR_INVALID_PARAMETER;
+            continue;
+        }
+        if (dynamic_cast<WinDetour*>(it->second.get())) {
+            detours.push_back(name);
+            slots.push_back(results.size() - 1);
+            continue;
+        }
+        if (!(apply ? it->second->Apply() : it->second->Restore()))
+            results.back().error = ERROR_WRITE_FAULT;
+    }
+
+    const auto detourResults = CommitDetours(detours, apply);
+    for (size_t i = 0; i < detourResults.size(); ++i) results[slots[i]].error = detourResults[i].error;
+
+    return results;
+}
+
+std::vector<MemoryOperator::HookResult> MemoryOperator::ApplyDetours(const std::vector<std::string>& names)
+{
+    return CommitDetours(names, true);
+}
+
+std::vector<MemoryOperator::HookResult> MemoryOperator::RestoreDetours(const std::vector<std::string>& names)
+{
+    return CommitDetours(names, false);
+}
+
+std::vector<MemoryOperator::HookResult> MemoryOperator::CommitDetours(const std::vector<std::string>& names, bool attach)
+{
+    std::lock_guard lock(operationsMutex);
+    std::vector<HookResult> results;
+    results.reserve(names.size());
+
+    std::vector<WinDetour*> detours;
+    std::vector<size_t>     slots;     // results index for each detours entry
+    detours.reserve(names.size());
+    slots.reserve(names.size());
+
+    for (const auto& name : names) {
+        results.push_back(HookResult{ name });
+        if (WinDetour* d = FindDetour(name)) {
+            detours.push_back(d);
+            slots.push_back(results.size() - 1);
+        }
+        else {
+            results.back().error = ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    std::vector<LONG> errors;
+    if (attach) WinDetour::AttachBatch(detours, &errors);
+    else        WinDetour::DetachBatch(detours, &errors);
+
+    for (size_t i = 0; i < slots.size(); ++i)
+        results[slots[i]].error = errors[i];
+
+    return results;
+}
+
+void MemoryOperator::BeginHookTransaction()
+{
+    hookTransactionOpen = true;
+    queuedHooks.clear();
+}
+
+void MemoryOperator::QueueHook(const std::string& name)
+{
+    queuedHooks.push_back(name);
+}
+
+std::vector<MemoryOperator::HookResult> MemoryOperator::CommitHookTransaction()
+{
+    hookTransactionOpen = false;
+    auto results = ApplyDetours(queuedHooks);
+    queuedHooks.clear();
+    return results;
+}
+
+void MemoryOperator::AbortHookTransaction()
+{
+    hookTransactionOpen = false;
+    queuedHooks.clear();
+}
+
+
 Patch* MemoryOperator::FindPatch(const std::string& name)
 {
+    std::lock_guard lock(operationsMutex);
     auto it = operations.find(name);
     if (it != operations.end()) {
         return dynamic_cast<Patch*>(it->second.get());
@@ -84,6 +376,7 @@ Patch* MemoryOperator::FindPatch(const std::string& name)
 
 WinDetour* MemoryOperator::FindDetour(const std::string& name)
 {
+    std::lock_guard lock(operationsMutex);
     auto it = operations.find(name);
     if (it != operations.end()) {
         return dynamic_cast<WinDetour*>(it->second.get());
@@ -91,11 +384,52 @@ WinDetour* MemoryOperator::FindDetour(const std::string& name)
     return nullptr;
 }
 
+InlineHook* MemoryOperator::FindInlineHook(const std::string& name)
+{
+    std::lock_guard lock(operationsMutex);
+    auto it = operations.find(name);
+    if (it != operations.end()) {
+        return dynamic_cast<InlineHook*>(it->second.get());
+    }
+    return nullptr;
+}
+
+MidHook* MemoryOperator::FindMidHook(const std::string& name)
+{
+    std::lock_guard lock(operationsMutex);
+    auto it = operations.find(name);
+    if (it != operations.end()) {
+        return dynamic_cast<MidHook*>(it->second.get());
+    }
+    return nullptr;
+}
+
+PointerHook* MemoryOperator::FindPointerHook(const std::string& name)
+{
+    std::lock_guard lock(operationsMutex);
+    auto it = operations.find(name);
+    if (it != operations.end()) {
+        return dynamic_cast<PointerHook*>(it->second.get());
+    }
+    return nullptr;
+}
+
+VTableInstanceHook* MemoryOperator::FindVTableInstanceHook(const std::string& name)
+{
+    std::lock_guard lock(operationsMutex);
+    auto it = operations.find(name);
+    if (it != operations.end()) {
+        return dynamic_cast<VTableInstanceHook*>(it->second.get());
+    }
+    return nullptr;
+}
+
 
 // i gotten the idea (code) From ByteWeaver / Oxkate
 bool MemoryOperator::IsLocationModified(uintptr_t address, size_t length,
     std::map<std::string, std::shared_ptr<MemoryOperation>>& out)
 {
+    std::lock_guard lock(operationsMutex);
     const auto end = address + length;
     std::ranges::copy_if(operations, std::inserter(out, out.end()),
         [=](const auto& kv) {
@@ -110,6 +444,7 @@ bool MemoryOperator::IsLocationModified(uintptr_t address, size_t length,
 
 BOOL MemoryOperator::DisposeAll(bool saveActive, const std::vector<std::string>& ignoreList)
 {
+    std::lock_guard lock(operationsMutex);
     auto* saved = saveActive ? &Savedoperations : nullptr;
 
     if (saved) saved->clear();
@@ -119,37 +454,63 @@ BOOL MemoryOperator::DisposeAll(bool saveActive, const std::vector<std::string>&
     ignore.reserve(ignoreList.size());
     for (const auto& s : ignoreList) ignore.emplace(s);
 
+    std::vector<WinDetour*> detours;
     for (auto& [name, op] : operations) {
         if (!op || !op->is_modified) continue;
         if (ignore.find(name) != ignore.end()) continue;
-        if (Memory::IsBadRange(op->address, op->size, /*write*/true)) continue;
+
+        if (auto detour = dynamic_cast<WinDetour*>(op.get())) {
+            if (saved) saved->emplace(name, op);
+            detours.push_back(detour);
+            continue;
+        }
+
+        if (Memory::IsBadRange(op->address, op->size, /*write*/false)) continue;
 
         if (saved) saved->emplace(name, op);
         op->Restore();
     }
 
+    // all detours leave in a single transaction; failed ones stay marked as modified
+    std::vector<LONG> errors;
+    WinDetour::DetachBatch(detours, &errors);
+    for (size_t i = 0; i < detours.size(); ++i) {
+        if (errors[i] != NO_ERROR)
+            std::cerr << "DisposeAll: detour at 0x" << std::hex << detours[i]->address << std::dec
+                      << " failed to detach (rc=" << errors[i] << ")\n";
+    }
+
     return TRUE;
 }
 
 
 BOOL MemoryOperator::ApplyAll(bool useSavedActive) 
 {
+    std::lock_guard lock(operationsMutex);
     auto& src = useSavedActive ? Savedoperations : operations;
 
-    for (auto& [name, op] : src)
-        if (op && (useSavedActive || !op->is_modified) &&
-            !Memory::IsBadRange(op->address, op->size, true))
-        {
-            op->Apply();
+    std::vector<WinDetour*> detours;
+    for (auto& [name, op] : src) {
+        if (!op || (!useSavedActive && op->is_modified)) continue;
+
+        if (auto detour = dynamic_cast<WinDetour*>(op.get())) {
+            detours.push_back(detour);
+            continue;
         }
 
+        if (!Memory::IsBadRange(op->address, op->size, false))
+            op->Apply();
+    }
+
+    WinDetour::AttachBatch(detours);
+
     return TRUE;
 }
 
 
 bool MemoryOperator::EraseAll()
 {
-
+    std::unique_lock operationsLock(operationsMutex);
 
     for (auto& [name, op] : operations) {
         if (!op) continue;
@@ -157,7 +518,7 @@ bool MemoryOperator::EraseAll()
         // If this op modified memory, try to restore the original bytes first.
         if (op->is_modified)
         {
-            if (!Memory::IsBadRange(op->address, op->size, /*write*/true)) {
+            if (!Memory::IsBadRange(op->address, op->size, /*write*/false)) {
                 op->Restore();                // put memory back
 				
             }
@@ -166,6 +527,11 @@ bool MemoryOperator::EraseAll()
     }
     operations.clear();
     Savedoperations.clear();
+    ++revision;
+    operationsLock.unlock();
+
+    std::lock_guard lock(pendingMutex);
+    pendingOperations.clear();
 
     return true;
 }
@@ -0,0 +1,296 @@
+#include "MidHook.h"
+#include "CodeAllocator.h"
+#include "CodePatcher.h"
+#include "CodeRelocator.h"
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+namespace
+{
+    struct Emitter
+    {
+        uint8_t* p;
+
+        void Bytes(std::initializer_list<uint8_t> bytes) { for (uint8_t b : bytes) *p++ = b; }
+        void U32(uint32_t v) { std::memcpy(p, &v, sizeof(v)); p += sizeof(v); }
+        void U64(uint64_t v) { std::memcpy(p, &v, sizeof(v)); p += sizeof(v); }
+    };
+
+    constexpr uint32_t kFrame = (sizeof(CONTEXT) + 15) & ~uint32_t(15);
+    constexpr uint32_t kContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
+
+#ifdef _WIN64
+    constexpr uint32_t kRedZone = 128;   // SysV leaf functions may keep data below rsp
+
+    uint32_t RegOffset(int reg) { return static_cast<uint32_t>(offsetof(CONTEXT, Rax) + 8 * reg); }
+    static_assert(offsetof(CONTEXT, R15) == offsetof(CONTEXT, Rax) + 15 * 8, "CONTEXT register order");
+
+    // mov [rsp+disp32], reg64
+    void StoreToRsp(Emitter& e, int reg, uint32_t disp)
+    {
+        e.Bytes({ uint8_t(0x48 | (reg >= 8 ? 4 : 0)), 0x89, uint8_t(0x84 | ((reg & 7) << 3)), 0x24 });
+        e.U32(disp);
+    }
+
+    // mov reg64, [rax+disp32]
+    void LoadFromRax(Emitter& e, int reg, uint32_t disp)
+    {
+        e.Bytes({ uint8_t(0x48 | (reg >= 8 ? 4 : 0)), 0x8B, uint8_t(0x80 | ((reg & 7) << 3)) });
+        e.U32(disp);
+    }
+
+    // movaps [rsp+disp32], xmmN (store) / movaps xmmN, [rsp+disp32] (load)
+    void MoveXmm(Emitter& e, int reg, uint32_t disp, bool store)
+    {
+        if (reg >= 8) e.Bytes({ 0x44 });
+        e.Bytes({ 0x0F, uint8_t(store ? 0x29 : 0x28), uint8_t(0x84 | ((reg & 7) << 3)), 0x24 });
+        e.U32(disp);
+    }
+
+    // x64 code keeps no state in x87, so XMM0-15 and MXCSR are all a callback can clobber;
+    // much cheaper than fxsave/fxrstor
+    void SaveSse(Emitter& e, bool store)
+    {
+        for (int reg = 0; reg < 16; ++reg)
+            MoveXmm(e, reg, static_cast<uint32_t>(offsetof(CONTEXT, Xmm0) + 16 * reg), store);
+        e.Bytes({ 0x0F, 0xAE, uint8_t(store ? 0x9C : 0x94), 0x24 });   // stmxcsr / ldmxcsr [rsp+MxCsr]
+        e.U32(offsetof(CONTEXT, MxCsr));
+    }
+    static_assert(offsetof(CONTEXT, Xmm15) == offsetof(CONTEXT, Xmm0) + 15 * 16, "CONTEXT xmm order");
+#else
+    // mov [esp+disp32], reg32
+    void StoreToEsp(Emitter& e, int reg, uint32_t disp)
+    {
+        e.Bytes({ 0x89, uint8_t(0x84 | (reg << 3)), 0x24 });
+        e.U32(disp);
+    }
+
+    // mov reg32, [eax+disp32]
+    void LoadFromEax(Emitter& e, int reg, uint32_t disp)
+    {
+        e.Bytes({ 0x8B, uint8_t(0x80 | (reg << 3)) });
+        e.U32(disp);
+    }
+#endif
+}
+
+size_t MidHook::EmitStub(uint8_t* out, size_t capacity, uintptr_t hookAddress, DispatchFn dispatch, void* user)
+{
+    if (!out || capacity < kMaxStubSize) return 0;
+    Emitter e{ out };
+
+#ifdef _WIN64
+    // Save flags and rax, then carve a 16-byte aligned CONTEXT below the red zone
+    e.Bytes({ 0x48, 0x8D, 0x64, 0x24, 0x80 });              // lea rsp, [rsp-128]
+    e.Bytes({ 0x9C });                                      // pushfq
+    e.Bytes({ 0x50 });                                      // push rax
+    e.Bytes({ 0x48, 0x89, 0xE0 });                          // mov rax, rsp
+    e.Bytes({ 0x48, 0x83, 0xE4, 0xF0 });                    // and rsp, -16
+    e.Bytes({ 0x48, 0x81, 0xEC }); e.U32(kFrame);           // sub rsp, kFrame
+
+    for (int reg = 1; reg < 16; ++reg) {
+        if (reg != 4) StoreToRsp(e, reg, RegOffset(reg));   // everything but rax/rsp
+    }
+
+    e.Bytes({ 0x48, 0x8B, 0x08 });                          // mov rcx, [rax]       (rax)
+    StoreToRsp(e, 1, RegOffset(0));
+    e.Bytes({ 0x48, 0x8B, 0x48, 0x08 });                    // mov rcx, [rax+8]     (rflags)
+    e.Bytes({ 0x89, 0x8C, 0x24 }); e.U32(offsetof(CONTEXT, EFlags));
+    e.Bytes({ 0x48, 0x8D, 0x88 }); e.U32(16 + kRedZone);    // lea rcx, [rax+144]   (rsp)
+    StoreToRsp(e, 1, RegOffset(4));
+    e.Bytes({ 0x48, 0xB9 }); e.U64(hookAddress);            // mov rcx, hookAddress
+    StoreToRsp(e, 1, offsetof(CONTEXT, Rip));
+    e.Bytes({ 0xC7, 0x84, 0x24 }); e.U32(offsetof(CONTEXT, ContextFlags)); e.U32(kContextFlags | CONTEXT_FLOATING_POINT);
+    SaveSse(e, true);
+
+    // dispatch(user, ctx)
+    e.Bytes({ 0x48, 0x89, 0xE2 });                          // mov rdx, rsp
+    e.Bytes({ 0x48, 0x89, 0xE6 });                          // mov rsi, rsp
+    e.Bytes({ 0x48, 0xB9 }); e.U64(reinterpret_cast<uintptr_t>(user));   // mov rcx, user
+    e.Bytes({ 0x48, 0xBF }); e.U64(reinterpret_cast<uintptr_t>(user));   // mov rdi, user
+    e.Bytes({ 0x48, 0x83, 0xEC, 0x20 });                    // sub rsp, 32 (shadow space)
+    e.Bytes({ 0x48, 0xB8 }); e.U64(reinterpret_cast<uintptr_t>(dispatch));
+    e.Bytes({ 0xFF, 0xD0 });                                // call rax
+    e.Bytes({ 0x48, 0x83, 0xC4, 0x20 });                    // add rsp, 32
+
+    SaveSse(e, false);
+
+    // Put rflags and the resume address just below ctx->Rsp's red zone, load the registers,
+    // then popfq + ret 128 lands on ctx->Rip with rsp == ctx->Rsp
+    e.Bytes({ 0x48, 0x89, 0xE0 });                          // mov rax, rsp
+    LoadFromRax(e, 1, RegOffset(4));                        // mov rcx, ctx->Rsp
+    e.Bytes({ 0x48, 0x81, 0xE9 }); e.U32(16 + kRedZone);    // sub rcx, 144
+    e.Bytes({ 0x8B, 0x90 }); e.U32(offsetof(CONTEXT, EFlags));   // mov edx, ctx->EFlags
+    e.Bytes({ 0x48, 0x89, 0x11 });                          // mov [rcx], rdx
+    LoadFromRax(e, 2, offsetof(CONTEXT, Rip));              // mov rdx, ctx->Rip
+    e.Bytes({ 0x48, 0x89, 0x51, 0x08 });                    // mov [rcx+8], rdx
+    e.Bytes({ 0x48, 0x89, 0xCC });                          // mov rsp, rcx
+
+    for (int reg = 1; reg < 16; ++reg) {
+        if (reg != 4) LoadFromRax(e, reg, RegOffset(reg));
+    }
+    LoadFromRax(e, 0, RegOffset(0));                        // rax last
+    e.Bytes({ 0x9D });                                      // popfq
+    e.Bytes({ 0xC2, kRedZone & 0xFF, kRedZone >> 8 });      // ret 128
+#else
+    // pushad order: edi, esi, ebp, esp, ebx, edx, ecx, eax; eflags above it
+    struct Slot { uint8_t pushad; uint32_t context; };
+    const Slot slots[] = {
+        { 0,  offsetof(CONTEXT, Edi) }, { 4,  offsetof(CONTEXT, Esi) }, { 8,  offsetof(CONTEXT, Ebp) },
+        { 16, offsetof(CONTEXT, Ebx) }, { 20, offsetof(CONTEXT, Edx) }, { 24, offsetof(CONTEXT, Ecx) },
+        { 28, offsetof(CONTEXT, Eax) }, { 32, offsetof(CONTEXT, EFlags) },
+    };
+    constexpr uint32_t kFxArea = 512;   // fxsave needs 16-byte alignment, ExtendedRegisters has none
+
+    e.Bytes({ 0x9C });                                      // pushfd
+    e.Bytes({ 0x60 });                                      // pushad
+    e.Bytes({ 0x89, 0xE0 });                                // mov eax, esp
+    e.Bytes({ 0x83, 0xE4, 0xF0 });                          // and esp, -16
+    e.Bytes({ 0x81, 0xEC }); e.U32(kFrame + kFxArea);       // sub esp, kFrame + 512
+
+    for (const Slot& s : slots) {
+        e.Bytes({ 0x8B, 0x48, s.pushad });                  // mov ecx, [eax+slot]
+        StoreToEsp(e, 1, s.context);
+    }
+    e.Bytes({ 0x8B, 0x48, 12 });                            // mov ecx, [eax+12]   (esp after pushfd)
+    e.Bytes({ 0x83, 0xC1, 0x04 });                          // add ecx, 4
+    StoreToEsp(e, 1, offsetof(CONTEXT, Esp));
+    e.Bytes({ 0xC7, 0x84, 0x24 }); e.U32(offsetof(CONTEXT, Eip)); e.U32(static_cast<uint32_t>(hookAddress));
+    e.Bytes({ 0xC7, 0x84, 0x24 }); e.U32(offsetof(CONTEXT, ContextFlags)); e.U32(kContextFlags);
+    e.Bytes({ 0x0F, 0xAE, 0x84, 0x24 }); e.U32(kFrame);    // fxsave [esp+kFrame]
+
+    e.Bytes({ 0x54 });                                      // push esp (ctx)
+    e.Bytes({ 0x68 }); e.U32(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(user)));
+    e.Bytes({ 0xB8 }); e.U32(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(dispatch)));
+    e.Bytes({ 0xFF, 0xD0 });                                // call eax
+    e.Bytes({ 0x83, 0xC4, 0x08 });                          // add esp, 8
+
+    e.Bytes({ 0x0F, 0xAE, 0x8C, 0x24 }); e.U32(kFrame);    // fxrstor [esp+kFrame]
+
+    e.Bytes({ 0x89, 0xE0 });                                // mov eax, esp
+    LoadFromEax(e, 1, offsetof(CONTEXT, Esp));              // mov ecx, ctx->Esp
+    e.Bytes({ 0x83, 0xE9, 0x08 });                          // sub ecx, 8
+    LoadFromEax(e, 2, offsetof(CONTEXT, EFlags));
+    e.Bytes({ 0x89, 0x11 });                                // mov [ecx], edx
+    LoadFromEax(e, 2, offsetof(CONTEXT, Eip));
+    e.Bytes({ 0x89, 0x51, 0x04 });                          // mov [ecx+4], edx
+    e.Bytes({ 0x89, 0xCC });                                // mov esp, ecx
+
+    LoadFromEax(e, 3, offsetof(CONTEXT, Ebx));
+    LoadFromEax(e, 5, offsetof(CONTEXT, Ebp));
+    LoadFromEax(e, 6, offsetof(CONTEXT, Esi));
+    LoadFromEax(e, 7, offsetof(CONTEXT, Edi));
+    LoadFromEax(e, 1, offsetof(CONTEXT, Ecx));
+    LoadFromEax(e, 2, offsetof(CONTEXT, Edx));
+    LoadFromEax(e, 0, offsetof(CONTEXT, Eax));
+    e.Bytes({ 0x9D });                                      // popfd
+    e.Bytes({ 0xC3 });                                      // ret
+#endif
+
+    return static_cast<size_t>(e.p - out);
+}
+
+void MidHook::Dispatch(void* self, PCONTEXT ctx)
+{
+    auto hook = static_cast<MidHook*>(self);
+    hook->callback(ctx);
+
+    // Untouched resume address: run the relocated instructions and continue
+#ifdef _WIN64
+    if (ctx->Rip == hook->address) ctx->Rip = reinterpret_cast<DWORD64>(hook->trampoline);
+#else
+    if (ctx->Eip == hook->address) ctx->Eip = reinterpret_cast<DWORD>(hook->trampoline);
+#endif
+}
+
+MidHook::MidHook(uintptr_t target, Callback cb)
+{
+    if (!target || !cb) {
+        throw std::invalid_argument("MidHook: null address or callback");
+    }
+
+    if (Memory::IsBadRange(target, kJumpSize + 15, false)) {
+        throw std::runtime_error("MidHook: address is not readable");
+    }
+
+    uint8_t* block = CodeAllocator::Allocate(kMaxStubSize + CodeRelocator::kMaxTrampolineSize, target);
+    if (!block) {
+        throw std::runtime_error("MidHook: no executable memory near the address");
+    }
+
+    uint8_t* stub = block;
+    uint8_t* relocated = block + kMaxStubSize;
+
+    size_t stolen = 0;
+    if (!CodeRelocator::Relocate(target, kJumpSize, relocated, CodeRelocator::kMaxTrampolineSize,
+            reinterpret_cast<uintptr_t>(relocated), &stolen)) {
+        throw std::runtime_error("MidHook: instructions at the address cannot be relocated");
+    }
+
+    if (!EmitStub(stub, kMaxStubSize, target, &MidHook::Dispatch, this)) {
+        throw std::runtime_error("MidHook: stub generation failed");
+    }
+    FlushInstructionCache(GetCurrentProcess(), block, kMaxStubSize + CodeRelocator::kMaxTrampolineSize);
+
+    jump[0] = 0xE9;
+    const int32_t rel = static_cast<int32_t>(static_cast<intptr_t>(reinterpret_cast<uintptr_t>(stub) - (target + kJumpSize)));
+    std::memcpy(jump + 1, &rel, sizeof(rel));
+
+    address = target;
+    size = stolen;
+    original_bytes = Memory::ReadBytes(target, stolen);
+    callback = cb;
+    trampoline = relocated;
+}
+
+MidHook::~MidHook()
+{
+    // The stub keeps pointing at this object; it is unreachable once the jump is gone
+    if (is_modified) {
+        try { Restore(); }
+        catch (...) {}
+    }
+}
+
+bool MidHook::Apply()
+{
+    if (is_modified) {
+        std::cout << "Mid hook already applied\n";
+        return true;
+    }
+
+    if (Memory::ReadBytes(address, size) != original_bytes) {
+        std::cerr << "[MidHook] Apply failed: target bytes changed at 0x" << std::hex << address << std::dec << "\n";
+        return false;
+    }
+
+    if (!CodePatcher::Write(address, jump, kJumpSize)) {
+        std::cerr << "[MidHook] Apply failed: cannot write at 0x" << std::hex << address << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = true;
+    return true;
+}
+
+bool MidHook::Restore()
+{
+    if (!is_modified) {
+        return true;
+    }
+
+    if (Memory::IsBadRange(address, kJumpSize, false)) {
+        std::cout << "Restore: target memory invalid, skipping\n";
+        is_modified = false;
+        return true;
+    }
+
+    if (!CodePatcher::Write(address, original_bytes.data(), kJumpSize)) {
+        std::cerr << "[MidHook] Restore failed: cannot write at 0x" << std::hex << address << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = false;
+    return true;
+}
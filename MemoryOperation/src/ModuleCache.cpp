@@ -0,0 +1,137 @@
+#include "ModuleCache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+ModuleCache::ModuleCache(const char* subdirectory, const char* extension, uint32_t magic, uint32_t version)
+    : subdirectory(subdirectory), extension(extension), magic(magic), version(version)
+{
+}
+
+void ModuleCache::Mapping::Close()
+{
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    view = nullptr;
+    mapping = nullptr;
+    size = 0;
+}
+
+const IMAGE_NT_HEADERS* ModuleCache::NtHeaders(uintptr_t base)
+{
+    auto dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+    if (!base || dos->e_magic != IMAGE_DOS_SIGNATURE) return nullptr;
+    auto nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dos->e_lfanew);
+    return nt->Signature == IMAGE_NT_SIGNATURE ? nt : nullptr;
+}
+
+bool ModuleCache::GetIdentity(uintptr_t base, Identity& out)
+{
+    const IMAGE_NT_HEADERS* nt = NtHeaders(base);
+    if (!nt) return false;
+
+    out.timeDateStamp = nt->FileHeader.TimeDateStamp;
+    out.sizeOfImage = nt->OptionalHeader.SizeOfImage;
+
+    char path[MAX_PATH];
+    const DWORD length = GetModuleFileNameA(reinterpret_cast<HMODULE>(base), path, MAX_PATH);
+    out.name = length ? std::filesystem::path(std::string(path, length)).filename().string() : "module";
+    return true;
+}
+
+void ModuleCache::SetDirectory(const std::string& directory)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->directory = directory;
+    directorySet = true;
+}
+
+std::string ModuleCache::GetPath(const Identity& module) const
+{
+    std::string base;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        base = directory;
+        if (!directorySet) {
+            char temp[MAX_PATH];
+            const DWORD length = GetTempPathA(MAX_PATH, temp);
+            if (!length || length >= MAX_PATH) return {};
+            base = (std::filesystem::path(temp) / "MemoryOperation" / subdirectory).string();
+        }
+    }
+    if (base.empty()) return {};
+
+    char key[32];
+    snprintf(key, sizeof(key), "-%08X%08X.%s", module.timeDateStamp, module.sizeOfImage, extension);
+    return (std::filesystem::path(base) / (module.name + key)).string();
+}
+
+ModuleCache::Header ModuleCache::MakeHeader(const Identity& module) const
+{
+    return Header{ magic, version, module.timeDateStamp, module.sizeOfImage };
+}
+
+bool ModuleCache::Map(const std::string& path, const Identity& module, Mapping& out) const
+{
+    out.Close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize{};
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= static_cast<LONGLONG>(sizeof(Header))) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);   // the mapping keeps the file open
+    if (!mapping) return false;
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    auto header = static_cast<const Header*>(view);
+    if (header->magic != magic || header->version != version ||
+        header->timeDateStamp != module.timeDateStamp || header->sizeOfImage != module.sizeOfImage) {
+        UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+
+    out.mapping = mapping;
+    out.view = view;
+    out.size = static_cast<uint64_t>(fileSize.QuadPart);
+    return true;
+}
+
+bool ModuleCache::Write(const std::string& path, std::initializer_list<Chunk> chunks) const
+{
+    std::error_code ec;
+    const std::filesystem::path target(path);
+    std::filesystem::create_directories(target.parent_path(), ec);
+
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+
+        for (const Chunk& chunk : chunks) {
+            out.write(static_cast<const char*>(chunk.data), std::streamsize(chunk.size));
+        }
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
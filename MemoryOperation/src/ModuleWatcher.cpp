@@ -0,0 +1,186 @@
+#include "ModuleWatcher.h"
+#include "MemoryOperator.h"
+#include "PatternScanner.h"
+#include <winternl.h>
+
+// ntdll loader notification types (not in the public SDK headers)
+namespace
+{
+    constexpr ULONG LDR_REASON_LOADED = 1;
+
+    struct LdrLoadedData
+    {
+        ULONG            Flags;
+        PCUNICODE_STRING FullDllName;
+        PCUNICODE_STRING BaseDllName;
+        PVOID            DllBase;
+        ULONG            SizeOfImage;
+    };
+
+    using LdrNotificationFn = VOID(CALLBACK*)(ULONG reason, const void* data, PVOID context);
+    using LdrRegisterFn     = LONG(NTAPI*)(ULONG flags, LdrNotificationFn callback, PVOID context, PVOID* cookie);
+    using LdrUnregisterFn   = LONG(NTAPI*)(PVOID cookie);
+
+    FARPROC GetNtdllExport(const char* name)
+    {
+        HMODULE ntdll = ::GetModuleHandleW(L"ntdll.dll");
+        return ntdll ? ::GetProcAddress(ntdll, name) : nullptr;
+    }
+}
+
+PVOID ModuleWatcher::s_cookie = nullptr;
+HANDLE ModuleWatcher::s_worker = nullptr;
+HANDLE ModuleWatcher::s_wake = nullptr;
+std::atomic<bool> ModuleWatcher::s_stop{ true };   // true while no worker runs
+std::vector<std::pair<std::string, uintptr_t>> ModuleWatcher::s_loaded;
+std::mutex ModuleWatcher::s_loadedMutex;
+
+uintptr_t ModuleTarget::Resolve(uintptr_t moduleBase) const
+{
+    if (!moduleBase) return 0;
+    if (pattern.empty()) return moduleBase + offset;
+
+    // Bounded to the image so a miss does not sweep the rest of the address space
+    const size_t moduleSize = Memory::GetModuleSize(moduleBase);
+    if (!moduleSize) return 0;
+
+    uintptr_t hit = 0;
+    Scanner scanner(moduleBase, pattern, moduleBase + moduleSize);
+    if (!scanner.Scan(&hit)) return 0;
+
+    return hit + offset;
+}
+
+bool ModuleWatcher::Install()
+{
+    if (s_cookie) return true;
+
+    auto reg = reinterpret_cast<LdrRegisterFn>(GetNtdllExport("LdrRegisterDllNotification"));
+    if (!reg) return false;
+
+    s_wake = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    s_worker = s_wake ? ::CreateThread(nullptr, 0, WorkerThread, nullptr, 0, nullptr) : nullptr;
+    if (!s_worker) {
+        if (s_wake) ::CloseHandle(s_wake);
+        s_wake = nullptr;
+        return false;
+    }
+    s_stop = false;
+
+    PVOID cookie = nullptr;
+    if (reg(0, LoaderNotification, nullptr, &cookie) != 0) {
+        Remove();
+        return false;
+    }
+
+    s_cookie = cookie;
+    return true;
+}
+
+void ModuleWatcher::Remove()
+{
+    if (s_cookie) {
+        if (auto unreg = reinterpret_cast<LdrUnregisterFn>(GetNtdllExport("LdrUnregisterDllNotification")))
+            unreg(s_cookie);
+        s_cookie = nullptr;
+    }
+
+    if (s_worker) {
+        {
+            std::lock_guard lock(s_loadedMutex);   // no Enqueue after the final drain below
+            s_stop = true;
+        }
+        ::SetEvent(s_wake);
+        // deadlocks under the loader lock, see the header
+        ::WaitForSingleObject(s_worker, INFINITE);
+        ::CloseHandle(s_worker);
+        s_worker = nullptr;
+    }
+    if (s_wake) {
+        ::CloseHandle(s_wake);
+        s_wake = nullptr;
+    }
+
+    // loads reported after the worker's last pass
+    DrainLoaded();
+}
+
+bool ModuleWatcher::IsInstalled()
+{
+    return s_cookie != nullptr;
+}
+
+size_t ModuleWatcher::Poll()
+{
+    size_t applied = DrainLoaded();
+    for (const auto& module : MemoryOperator::GetPendingModules()) {
+        if (HMODULE h = ::GetModuleHandleA(module.c_str()))
+            applied += MemoryOperator::ResolvePending(module, reinterpret_cast<uintptr_t>(h));
+    }
+    return applied;
+}
+
+bool ModuleWatcher::Enqueue(const std::string& module, uintptr_t base)
+{
+    // s_wake is signalled under the mutex so Remove cannot close it in between
+    std::lock_guard lock(s_loadedMutex);
+    if (s_stop) return false;
+    s_loaded.emplace_back(NormalizeName(module), base);
+    ::SetEvent(s_wake);
+    return true;
+}
+
+std::string ModuleWatcher::NormalizeName(const std::string& module)
+{
+    std::string out = module;
+    std::transform(out.begin(), out.end(), out.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return out;
+}
+
+size_t ModuleWatcher::DrainLoaded()
+{
+    std::vector<std::pair<std::string, uintptr_t>> loaded;
+    {
+        std::lock_guard lock(s_loadedMutex);
+        loaded.swap(s_loaded);
+    }
+
+    // skip modules that were unloaded again before we got to them
+    size_t applied = 0;
+    for (const auto& [module, base] : loaded) {
+        if (reinterpret_cast<uintptr_t>(::GetModuleHandleA(module.c_str())) == base)
+            applied += MemoryOperator::ResolvePending(module, base);
+    }
+    return applied;
+}
+
+DWORD WINAPI ModuleWatcher::WorkerThread(LPVOID)
+{
+    while (::WaitForSingleObject(s_wake, INFINITE) == WAIT_OBJECT_0 && !s_stop)
+        DrainLoaded();
+    return 0;
+}
+
+// Runs under the loader lock: no scanning, no patching and no thread suspension here
+// (a suspended thread may own the lock). Record the module and wake the worker.
+VOID CALLBACK ModuleWatcher::LoaderNotification(ULONG reason, const void* data, PVOID)
+{
+    if (reason != LDR_REASON_LOADED || !data) return;
+
+    auto loaded = static_cast<const LdrLoadedData*>(data);
+    if (!loaded->BaseDllName || !loaded->BaseDllName->Buffer || !loaded->DllBase) return;
+
+    const int wideLen = loaded->BaseDllName->Length / sizeof(WCHAR);
+    const int len = ::WideCharToMultiByte(CP_UTF8, 0, loaded->BaseDllName->Buffer, wideLen, nullptr, 0, nullptr, nullptr);
+    if (len <= 0) return;
+
+    std::string name(len, '\0');
+    ::WideCharToMultiByte(CP_UTF8, 0, loaded->BaseDllName->Buffer, wideLen, name.data(), len, nullptr, nullptr);
+
+    {
+        std::lock_guard lock(s_loadedMutex);
+        s_loaded.emplace_back(NormalizeName(name), reinterpret_cast<uintptr_t>(loaded->DllBase));
+    }
+    ::SetEvent(s_wake);
+}
@@ -0,0 +1,172 @@
+#include "PatchProfiles.h"
+#include "MemoryOperator.h"
+
+std::map<std::string, std::vector<std::string>> PatchProfiles::groups;
+std::map<std::string, PatchProfiles::Profile> PatchProfiles::profiles;
+std::map<std::pair<std::string, std::string>, PatchProfiles::Transition> PatchProfiles::transitions;
+std::string PatchProfiles::activeProfile;
+std::string PatchProfiles::previousProfile;
+
+namespace
+{
+    bool ByPointer(const std::shared_ptr<MemoryOperation>& a, const std::shared_ptr<MemoryOperation>& b)
+    {
+        return a.get() < b.get();
+    }
+}
+
+bool PatchProfiles::DefineGroup(const std::string& group, const std::vector<std::string>& operations)
+{
+    if (group.empty()) return false;
+
+    groups[group] = operations;
+
+    // any profile may reference this group
+    for (auto& [name, profile] : profiles) profile.revision = ~0ull;
+    transitions.clear();
+    return true;
+}
+
+bool PatchProfiles::DefineProfile(const std::string& profile, const std::vector<std::string>& groupNames)
+{
+    if (profile.empty()) return false;
+
+    profiles[profile] = Profile{ groupNames };
+    transitions.clear();
+    return true;
+}
+
+const PatchProfiles::OperationList* PatchProfiles::Resolve(const std::string& name)
+{
+    static const OperationList none{};
+    if (name.empty()) return &none;
+
+    auto it = profiles.find(name);
+    if (it == profiles.end()) return nullptr;
+
+    Profile& profile = it->second;
+    if (profile.revision == MemoryOperator::GetRevision()) return &profile.resolved;
+
+    std::lock_guard lock(MemoryOperator::GetOperationsMutex());
+    const auto& ops = MemoryOperator::GetOperations();
+    profile.resolved.clear();
+
+    for (const auto& groupName : profile.groups) {
+        auto group = groups.find(groupName);
+        if (group == groups.end()) {
+            std::cerr << "PatchProfiles: profile '" << name << "' references unknown group '" << groupName << "'\n";
+            continue;
+        }
+        for (const auto& opName : group->second) {
+            auto op = ops.find(opName);
+            if (op != ops.end() && op->second) profile.resolved.push_back(op->second);
+            else if (MemoryOperator::DEBUG) std::cout << "[PatchProfiles] '" << opName << "' not registered (yet)\n";
+        }
+    }
+
+    std::ranges::sort(profile.resolved, ByPointer);
+    profile.resolved.erase(std::unique(profile.resolved.begin(), profile.resolved.end()), profile.resolved.end());
+    profile.revision = MemoryOperator::GetRevision();
+    return &profile.resolved;
+}
+
+const PatchProfiles::Transition* PatchProfiles::GetTransition(const std::string& from, const std::string& to)
+{
+    auto& transition = transitions[{ from, to }];
+    if (transition.revision == MemoryOperator::GetRevision()) return &transition;
+
+    const OperationList* a = Resolve(from);
+    const OperationList* b = Resolve(to);
+    if (!a || !b) return nullptr;
+
+    transition.toRestore.clear();
+    transition.toApply.clear();
+    std::ranges::set_difference(*a, *b, std::back_inserter(transition.toRestore), ByPointer);
+    std::ranges::set_difference(*b, *a, std::back_inserter(transition.toApply), ByPointer);
+    transition.revision = MemoryOperator::GetRevision();
+    return &transition;
+}
+
+bool PatchProfiles::Commit(const Transition& transition)
+{
+    // every state change made so far, so a failure can be unwound in reverse
+    std::vector<std::pair<MemoryOperation*, bool>> done;
+    done.reserve(transition.toRestore.size() + transition.toApply.size());
+
+    // Patches change one at a time; the detours of a phase share one Detours transaction
+    auto phase = [&](const OperationList& list, bool apply) {
+        std::vector<WinDetour*> detours;
+        for (const auto& op : list) {
+            if (op->is_modified == apply) continue;   // already in the wanted state, not ours to undo
+
+            if (auto detour = dynamic_cast<WinDetour*>(op.get())) {
+                detours.push_back(detour);
+                continue;
+            }
+            if (!(apply ? op->Apply() : op->Restore())) return false;
+            done.emplace_back(op.get(), apply);
+        }
+
+        if (detours.empty()) return true;
+
+        std::vector<LONG> errors;
+        if (apply) WinDetour::AttachBatch(detours, &errors);
+        else       WinDetour::DetachBatch(detours, &errors);
+
+        bool ok = true;
+        for (size_t i = 0; i < detours.size(); ++i) {
+            if (errors[i] == NO_ERROR) done.emplace_back(detours[i], apply);
+            else ok = false;
+        }
+        return ok;
+    };
+
+    if (phase(transition.toRestore, false) && phase(transition.toApply, true)) return true;
+
+    std::vector<WinDetour*> reattach, redetach;
+    for (auto it = done.rbegin(); it != done.rend(); ++it) {
+        auto [op, applied] = *it;
+        if (auto detour = dynamic_cast<WinDetour*>(op)) (applied ? redetach : reattach).push_back(detour);
+        else if (applied) op->Restore();
+        else op->Apply();
+    }
+    WinDetour::DetachBatch(redetach);
+    WinDetour::AttachBatch(reattach);
+
+    return false;
+}
+
+bool PatchProfiles::SwitchTo(const std::string& profile)
+{
+    if (profile == activeProfile) return true;
+    if (!profile.empty() && !profiles.contains(profile)) return false;
+
+    const Transition* transition = GetTransition(activeProfile, profile);
+    if (!transition) return false;
+
+    if (!Commit(*transition)) {
+        std::cerr << "PatchProfiles: switch '" << activeProfile << "' -> '" << profile << "' failed, rolled back\n";
+        return false;
+    }
+
+    if (MemoryOperator::DEBUG)
+        std::cout << "[PatchProfiles] '" << activeProfile << "' -> '" << profile << "': "
+            << transition->toRestore.size() << " restored, " << transition->toApply.size() << " applied\n";
+
+    previousProfile = std::exchange(activeProfile, profile);
+    return true;
+}
+
+bool PatchProfiles::Rollback()
+{
+    return SwitchTo(previousProfile);
+}
+
+void PatchProfiles::Clear()
+{
+    groups.clear();
+    profiles.clear();
+    transitions.clear();
+    activeProfile.clear();
+    previousProfile.clear();
+}
@@ -1,9 +1,11 @@
 #include "PatternScanner.h"
+#include <algorithm>
 #include <iostream>
 
-Scanner::Scanner(uintptr_t Address, const std::string& pattern)
+Scanner::Scanner(uintptr_t Address, const std::string& pattern, uintptr_t EndAddress)
 {
 	this->startAddress = Address ? Address : reinterpret_cast<uintptr_t>(GetModuleHandle(NULL));
+	this->endAddress = EndAddress;
     if (!Scanner::ParsePattern(pattern))
     {
         std::cout << "Failed to parse pattern: " << pattern << std::endl;
@@ -15,6 +17,7 @@ Scanner::~Scanner()
     this->pattern.clear();
 	this->mask.clear();
     this->startAddress = NULL;
+    this->endAddress = NULL;
 }
 
 // Add methods for pattern scanning here
@@ -52,7 +55,7 @@ bool Scanner::Scan(uintptr_t* results)
 
     SYSTEM_INFO sysInfo{};
     GetSystemInfo(&sysInfo);
-    const uintptr_t endAddress = reinterpret_cast<uintptr_t>(sysInfo.lpMaximumApplicationAddress);
+    const uintptr_t endAddress = this->endAddress ? this->endAddress : reinterpret_cast<uintptr_t>(sysInfo.lpMaximumApplicationAddress);
 
     MEMORY_BASIC_INFORMATION mbi{};
     uintptr_t currentAddress = startAddress;
@@ -65,11 +68,11 @@ bool Scanner::Scan(uintptr_t* results)
             (mbi.Protect & (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE)) &&
             !(mbi.Protect & PAGE_GUARD))
         {
-            uintptr_t regionStart = reinterpret_cast<uintptr_t>(mbi.BaseAddress);
-            uintptr_t regionEnd = regionStart + mbi.RegionSize;
+            uintptr_t regionStart = (std::max)(reinterpret_cast<uintptr_t>(mbi.BaseAddress), startAddress);
+            uintptr_t regionEnd = (std::min)(reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize, endAddress);
 
             // Scan this memory region
-            for (uintptr_t addr = regionStart; addr < regionEnd - pattern.size(); ++addr)
+            for (uintptr_t addr = regionStart; addr + pattern.size() <= regionEnd; ++addr)
             {
                 bool found = true;
                 const uint8_t* data = reinterpret_cast<const uint8_t*>(addr);
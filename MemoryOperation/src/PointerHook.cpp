@@ -0,0 +1,88 @@
+#include "PointerHook.h"
+#include <cstring>
+
+void PointerHook::Init(uintptr_t slot, uintptr_t value)
+{
+    if (!slot || !value) {
+        throw std::invalid_argument("PointerHook: null slot or replacement");
+    }
+    if (Memory::IsBadRange(slot, sizeof(uintptr_t), false)) {
+        throw std::runtime_error("PointerHook: slot is not readable");
+    }
+
+    address = slot;
+    size = sizeof(uintptr_t);
+    original_bytes = Memory::ReadBytes(slot, size);
+    std::memcpy(&originalValue, original_bytes.data(), sizeof(originalValue));
+    replacementValue = value;
+}
+
+PointerHook::~PointerHook()
+{
+    if (is_modified) {
+        try { Restore(); }
+        catch (...) {}
+    }
+}
+
+bool PointerHook::Swap(uintptr_t slot, uintptr_t expected, uintptr_t desired)
+{
+    // IATs and vtables usually live in read-only pages; keep execute rights if the slot
+    // shares a page with code, or other threads running there would fault
+    MEMORY_BASIC_INFORMATION mbi{};
+    if (!VirtualQuery(reinterpret_cast<LPCVOID>(slot), &mbi, sizeof(mbi)))
+        return false;
+
+    const DWORD executable = PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+    const DWORD writable = (mbi.Protect & executable) ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+
+    DWORD old_protection;
+    if (!VirtualProtect(reinterpret_cast<LPVOID>(slot), sizeof(uintptr_t), writable, &old_protection))
+        return false;
+
+    const PVOID seen = InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(slot),
+        reinterpret_cast<PVOID>(desired), reinterpret_cast<PVOID>(expected));
+
+    DWORD temp;
+    VirtualProtect(reinterpret_cast<LPVOID>(slot), sizeof(uintptr_t), old_protection, &temp);
+
+    return reinterpret_cast<uintptr_t>(seen) == expected;
+}
+
+bool PointerHook::Apply()
+{
+    if (is_modified) {
+        return true;
+    }
+
+    if (!Swap(address, originalValue, replacementValue)) {
+        std::cerr << "[PointerHook] Apply failed: slot 0x" << std::hex << address
+            << " no longer holds 0x" << originalValue << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = true;
+    return true;
+}
+
+bool PointerHook::Restore()
+{
+    if (!is_modified) {
+        return true;
+    }
+
+    if (Memory::IsBadRange(address, sizeof(uintptr_t), false)) {
+        std::cout << "Restore: slot memory invalid, skipping\n";
+        is_modified = false;
+        return true;
+    }
+
+    if (!Swap(address, replacementValue, originalValue)) {
+        std::cerr << "[PointerHook] Restore failed: slot 0x" << std::hex << address
+            << " was redirected again by someone else" << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = false;
+    return true;
+}
@@ -0,0 +1,405 @@
+#include "PointerScanner.h"
+#include "Memory.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+namespace
+{
+    constexpr uint32_t kFileMagic = 0x5254504D;   // "MPTR"
+    constexpr uint32_t kFileVersion = 1;
+    constexpr size_t   kChunkSize = 1 << 20;      // bytes per sweep work item
+
+    // File: FileHeader, per module (uint16_t length + name), then Path[pathCount]
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t moduleCount;
+        uint32_t pathCount;
+    };
+
+    constexpr DWORD kReadable = PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY |
+        PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+    // Growable array in its own VirtualAlloc pages. Build() keeps its working data here: pages
+    // allocated after the snapshot are never part of the regions being swept, heap blocks may be.
+    template<typename T>
+    class PageArray
+    {
+    public:
+        PageArray() = default;
+        ~PageArray()
+        {
+            if (items) VirtualFree(items, 0, MEM_RELEASE);
+        }
+        PageArray(const PageArray&) = delete;
+        PageArray& operator=(const PageArray&) = delete;
+
+        bool Reserve(size_t count)
+        {
+            if (count <= capacity) return true;
+            void* memory = VirtualAlloc(nullptr, count * sizeof(T), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+            if (!memory) return false;
+            if (items) {
+                memcpy(memory, items, used * sizeof(T));
+                VirtualFree(items, 0, MEM_RELEASE);
+            }
+            items = static_cast<T*>(memory);
+            capacity = count;
+            return true;
+        }
+
+        bool PushBack(const T& item)
+        {
+            if (used == capacity && !Reserve((std::max)(capacity * 2, 0x10000 / sizeof(T)))) return false;
+            items[used++] = item;
+            return true;
+        }
+
+        T*       Data() { return items; }
+        const T* begin() const { return items; }
+        const T* end() const { return items + used; }
+        size_t   Size() const { return used; }
+
+    private:
+        T*     items = nullptr;
+        size_t used = 0;
+        size_t capacity = 0;
+    };
+
+    struct Span
+    {
+        uintptr_t begin;
+        uintptr_t end;
+    };
+
+    template<typename T>
+    Span SpanOf(const std::vector<T>& items)
+    {
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(items.data());
+        return { begin, begin + items.size() * sizeof(T) };
+    }
+
+    bool Follow(uintptr_t moduleBase, const PointerScanner::Path& path, uintptr_t& out)
+    {
+        if (!moduleBase || path.depth == 0 || path.depth > PointerScanner::kMaxDepth) return false;
+
+        uintptr_t address = moduleBase + path.rva;
+        for (uint8_t i = 0; i < path.depth; i++) {
+            uintptr_t value = 0;
+            if (!Memory::ReadRaw(address, &value, sizeof(value))) return false;
+            address = value + static_cast<intptr_t>(path.offsets[i]);
+        }
+        out = address;
+        return true;
+    }
+}
+
+bool PointerScanner::Build()
+{
+    // before the snapshot, so the previous index is not swept as process memory
+    ReleaseEntries();
+
+    SYSTEM_INFO sysInfo{};
+    GetSystemInfo(&sysInfo);
+    const uintptr_t endAddress = reinterpret_cast<uintptr_t>(sysInfo.lpMaximumApplicationAddress);
+
+    std::vector<Module> foundModules;
+    std::vector<Region> found;
+    std::map<uintptr_t, int> moduleIndex;   // allocation base -> index
+
+    MEMORY_BASIC_INFORMATION mbi{};
+    uintptr_t current = reinterpret_cast<uintptr_t>(sysInfo.lpMinimumApplicationAddress);
+    while (current < endAddress && VirtualQuery(reinterpret_cast<LPCVOID>(current), &mbi, sizeof(mbi))) {
+        if (mbi.State == MEM_COMMIT && (mbi.Protect & kReadable) && !(mbi.Protect & (PAGE_GUARD | PAGE_NOACCESS))) {
+            Region region;
+            region.base = reinterpret_cast<uintptr_t>(mbi.BaseAddress);
+            region.size = mbi.RegionSize;
+
+            if (mbi.Type == MEM_IMAGE) {
+                const uintptr_t allocationBase = reinterpret_cast<uintptr_t>(mbi.AllocationBase);
+                auto it = moduleIndex.find(allocationBase);
+                if (it == moduleIndex.end()) {
+                    char path[MAX_PATH];
+                    const DWORD length = GetModuleFileNameA(reinterpret_cast<HMODULE>(allocationBase), path, MAX_PATH);
+                    Module module;
+                    module.name = length ? std::filesystem::path(std::string(path, length)).filename().string() : "module";
+                    module.base = allocationBase;
+                    it = moduleIndex.emplace(allocationBase, static_cast<int>(foundModules.size())).first;
+                    foundModules.push_back(module);
+                }
+                region.module = it->second;
+            }
+            found.push_back(region);
+        }
+
+        const uintptr_t next = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+        if (next <= current) break;
+        current = next;
+    }
+
+    return Build(foundModules, found);
+}
+
+bool PointerScanner::Build(const std::vector<Module>& modules, const std::vector<Region>& regions)
+{
+    ReleaseEntries();
+    this->modules = modules;
+    this->regions = regions;
+    std::sort(this->regions.begin(), this->regions.end(), [](const Region& a, const Region& b) { return a.base < b.base; });
+    if (this->regions.empty()) return false;
+
+    const uintptr_t lowest = this->regions.front().base;
+    const uintptr_t highest = this->regions.back().base + this->regions.back().size;
+
+    // Work items of at most kChunkSize, so one huge heap does not end up on a single core
+    struct Chunk
+    {
+        const Region* region;
+        uintptr_t     start;
+        size_t        size;
+    };
+    size_t chunkCount = 0;
+    for (const Region& region : this->regions) chunkCount += region.size / kChunkSize + 1;
+
+    PageArray<Chunk> chunks;
+    if (!chunks.Reserve(chunkCount)) return false;
+    for (const Region& region : this->regions) {
+        const uintptr_t first = (region.base + sizeof(uintptr_t) - 1) & ~uintptr_t(sizeof(uintptr_t) - 1);
+        const uintptr_t end = region.base + region.size;
+        for (uintptr_t start = first; start + sizeof(uintptr_t) <= end; start += kChunkSize) {
+            chunks.PushBack({ &region, start, (std::min)(kChunkSize, static_cast<size_t>(end - start)) });
+        }
+    }
+
+    // The module and region lists are ordinary heap blocks full of addresses and may lie in a
+    // swept region; pointers stored there are the scanner's own, not the process's
+    const Span own[] = { SpanOf(modules), SpanOf(regions), SpanOf(this->modules), SpanOf(this->regions) };
+
+    std::vector<PageArray<Entry>> found(chunks.Size());
+    Parallel::For(chunks.Size(), [&](size_t i) {
+        const Chunk& chunk = chunks.Data()[i];
+        const uintptr_t* words;
+        thread_local PageArray<uintptr_t> buffer;
+
+        const size_t count = chunk.size / sizeof(uintptr_t);
+        if (chunk.region->data) {
+            words = reinterpret_cast<const uintptr_t*>(chunk.region->data + (chunk.start - chunk.region->base));
+        }
+        else {
+            if (!buffer.Reserve(kChunkSize / sizeof(uintptr_t))) return;
+            if (!Memory::ReadRaw(chunk.start, buffer.Data(), count * sizeof(uintptr_t))) return;
+            words = buffer.Data();
+        }
+
+        PageArray<Entry>& out = found[i];
+        for (size_t w = 0; w < count; w++) {
+            uintptr_t value;
+            memcpy(&value, words + w, sizeof(value));   // synthetic data need not be aligned
+            if (value < lowest || value >= highest || !FindRegion(value)) continue;
+
+            const uintptr_t location = chunk.start + w * sizeof(uintptr_t);
+            if (std::any_of(std::begin(own), std::end(own), [&](const Span& span) { return location >= span.begin && location < span.end; })) continue;
+            if (!out.PushBack({ value, location })) return;
+        }
+    });
+
+    std::vector<size_t> offsets(found.size() + 1, 0);
+    for (size_t i = 0; i < found.size(); i++) offsets[i + 1] = offsets[i] + found[i].Size();
+    entries.resize(offsets.back());
+    Parallel::For(found.size(), [&](size_t i) {
+        std::copy(found[i].begin(), found[i].end(), entries.begin() + offsets[i]);
+    });
+
+    Parallel::Sort(entries, [](const Entry& a, const Entry& b) {
+        return a.value != b.value ? a.value < b.value : a.location < b.location;
+    });
+    return true;
+}
+
+// Every old Entry holds two valid pointers; a freed heap block keeps its contents, so clear
+// them before handing the buffer back
+void PointerScanner::ReleaseEntries()
+{
+    std::fill(entries.begin(), entries.end(), Entry{});
+    std::vector<Entry>().swap(entries);
+}
+
+const PointerScanner::Region* PointerScanner::FindRegion(uintptr_t address) const
+{
+    auto at = std::upper_bound(regions.begin(), regions.end(), address,
+        [](uintptr_t value, const Region& r) { return value < r.base; });
+    if (at == regions.begin()) return nullptr;
+    --at;
+    return address < at->base + at->size ? &*at : nullptr;
+}
+
+PointerScanner::PathSet PointerScanner::Scan(uintptr_t target, const Options& options) const
+{
+    PathSet set;
+    for (const Module& module : modules) set.modules.push_back(module.name);
+
+    const size_t maxDepth = (std::min)(options.maxDepth, kMaxDepth);
+    if (!maxDepth || entries.empty() || !options.maxResults) return set;
+
+    // Breadth-first over distinct addresses: links[n] holds every pointer location n+1 links away
+    // from the target (each location once, however many routes reach it), ends[n] the ones inside
+    // a module image. The work per level is bounded by the entry count instead of growing with
+    // the number of routes.
+    struct Node
+    {
+        uintptr_t location;
+        uintptr_t value;
+    };
+    std::vector<std::vector<Node>> links(maxDepth), ends(maxDepth);
+
+    std::vector<uintptr_t> frontier{ target };   // sorted
+    for (size_t level = 0; level < maxDepth && !frontier.empty(); level++) {
+        // Entries within maxOffset below any frontier address; overlapping windows are merged
+        // so each entry is taken at most once per level
+        std::vector<Node> nodes;
+        for (size_t i = 0; i < frontier.size();) {
+            const uintptr_t low = frontier[i] >= options.maxOffset ? frontier[i] - options.maxOffset : 0;
+            uintptr_t high = frontier[i];
+            for (++i; i < frontier.size() && frontier[i] <= high + options.maxOffset; ++i) high = frontier[i];
+
+            auto first = std::lower_bound(entries.begin(), entries.end(), low,
+                [](const Entry& e, uintptr_t v) { return e.value < v; });
+            for (; first != entries.end() && first->value <= high; ++first) nodes.push_back({ first->location, first->value });
+        }
+        Parallel::Sort(nodes, [](const Node& a, const Node& b) { return a.location < b.location; });
+
+        frontier.clear();
+        for (const Node& node : nodes) {
+            const Region* region = FindRegion(node.location);
+            if (region && region->module >= 0) {
+                ends[level].push_back(node);
+            }
+            else if (level + 1 < maxDepth) {
+                links[level].push_back(node);
+                frontier.push_back(node.location);
+            }
+        }
+    }
+
+    // Paths run from a module slot down to the target; the links one level below a node are the
+    // ones stored within maxOffset above the value it holds. Shorter paths come first.
+    Path path;
+    auto descend = [&](auto& self, uintptr_t value, size_t level, size_t index) -> void {
+        if (set.paths.size() >= options.maxResults) return;
+        if (level == 0) {
+            path.offsets[index] = static_cast<int32_t>(target - value);
+            set.paths.push_back(path);
+            return;
+        }
+
+        const std::vector<Node>& below = links[level - 1];
+        const uintptr_t high = value + (std::min)(options.maxOffset, static_cast<size_t>(UINTPTR_MAX - value));
+        auto it = std::lower_bound(below.begin(), below.end(), value,
+            [](const Node& n, uintptr_t v) { return n.location < v; });
+        for (; it != below.end() && it->location <= high; ++it) {
+            path.offsets[index] = static_cast<int32_t>(it->location - value);
+            self(self, it->value, level - 1, index + 1);
+        }
+    };
+
+    for (size_t level = 0; level < maxDepth; level++) {
+        for (const Node& end : ends[level]) {
+            const Region* region = FindRegion(end.location);
+            path = Path{};
+            path.module = static_cast<uint16_t>(region->module);
+            path.depth = static_cast<uint8_t>(level + 1);
+            path.rva = static_cast<uint32_t>(end.location - modules[region->module].base);
+            descend(descend, end.value, level, 0);
+        }
+    }
+    return set;
+}
+
+bool PointerScanner::Resolve(const PathSet& set, const Path& path, uintptr_t& out)
+{
+    if (path.module >= set.modules.size()) return false;
+    const uintptr_t base = reinterpret_cast<uintptr_t>(GetModuleHandleA(set.modules[path.module].c_str()));
+    return Follow(base, path, out);
+}
+
+size_t PointerScanner::Validate(PathSet& set, uintptr_t target)
+{
+    std::vector<uintptr_t> bases(set.modules.size());
+    for (size_t i = 0; i < bases.size(); i++) {
+        bases[i] = reinterpret_cast<uintptr_t>(GetModuleHandleA(set.modules[i].c_str()));
+    }
+
+    std::vector<uint8_t> keep(set.paths.size(), 0);
+    const size_t kBatch = 4096;
+    Parallel::For((set.paths.size() + kBatch - 1) / kBatch, [&](size_t batch) {
+        const size_t end = (std::min)(set.paths.size(), (batch + 1) * kBatch);
+        for (size_t i = batch * kBatch; i < end; i++) {
+            const Path& path = set.paths[i];
+            uintptr_t address = 0;
+            keep[i] = path.module < bases.size() && Follow(bases[path.module], path, address) && address == target;
+        }
+    });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < set.paths.size(); i++) {
+        if (keep[i]) set.paths[kept++] = set.paths[i];
+    }
+    set.paths.resize(kept);
+    return kept;
+}
+
+bool PointerScanner::Save(const PathSet& set, const std::string& path)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    const FileHeader header{ kFileMagic, kFileVersion, static_cast<uint32_t>(set.modules.size()), static_cast<uint32_t>(set.paths.size()) };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const std::string& name : set.modules) {
+        const uint16_t length = static_cast<uint16_t>(name.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(name.data(), length);
+    }
+    out.write(reinterpret_cast<const char*>(set.paths.data()), std::streamsize(set.paths.size() * sizeof(Path)));
+    return static_cast<bool>(out);
+}
+
+bool PointerScanner::Load(const std::string& path, PathSet& set)
+{
+    std::ifstream in(path, std::ios::binary);
+    FileHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != kFileMagic || header.version != kFileVersion) {
+        return false;
+    }
+
+    set.modules.assign(header.moduleCount, {});
+    for (std::string& name : set.modules) {
+        uint16_t length = 0;
+        if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+        name.resize(length);
+        if (!in.read(name.data(), length)) return false;
+    }
+    set.paths.resize(header.pathCount);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(set.paths.data()), std::streamsize(set.paths.size() * sizeof(Path))));
+}
+
+std::string PointerScanner::Format(const PathSet& set, const Path& path)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "+0x%X", path.rva);
+    std::string result = (path.module < set.modules.size() ? set.modules[path.module] : "?") + buffer;
+
+    for (uint8_t i = 0; i < path.depth && i < kMaxDepth; i++) {
+        const int32_t offset = path.offsets[i];
+        snprintf(buffer, sizeof(buffer), offset < 0 ? " -> -0x%X" : " -> 0x%X", offset < 0 ? 0u - uint32_t(offset) : uint32_t(offset));
+        result += buffer;
+    }
+    return result;
+}
@@ -0,0 +1,39 @@
+#include "ProcessThreads.h"
+#include <tlhelp32.h>
+
+std::vector<DWORD> ProcessThreads::EnumerateOthers()
+{
+    std::vector<DWORD> ids;
+
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return ids;
+
+    const DWORD pid = GetCurrentProcessId();
+    const DWORD self = GetCurrentThreadId();
+
+    THREADENTRY32 entry{};
+    entry.dwSize = sizeof(entry);
+    for (BOOL ok = Thread32First(snapshot, &entry); ok; ok = Thread32Next(snapshot, &entry)) {
+        if (entry.th32OwnerProcessID == pid && entry.th32ThreadID != self)
+            ids.push_back(entry.th32ThreadID);
+    }
+
+    CloseHandle(snapshot);
+    return ids;
+}
+
+std::vector<HANDLE> ProcessThreads::OpenOthers(DWORD access)
+{
+    std::vector<HANDLE> handles;
+    for (DWORD id : EnumerateOthers()) {
+        if (HANDLE h = OpenThread(access, FALSE, id))
+            handles.push_back(h);
+    }
+    return handles;
+}
+
+void ProcessThreads::CloseAll(std::vector<HANDLE>& handles)
+{
+    for (HANDLE h : handles) CloseHandle(h);
+    handles.clear();
+}
@@ -0,0 +1,415 @@
+#include "Profiler.h"
+#include "ProcessThreads.h"
+#include "Symbolizer.h"
+#include "Traceback.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Node
+    {
+        uintptr_t address = 0;   // frame 0: sampled pc; outer frames: return address - 1
+        uint32_t  parent = 0;
+        uint32_t  self = 0;      // samples ending here
+        uint32_t  total = 0;     // samples passing through
+    };
+
+    // Node 0 is the root. A child is found by hashing (parent, address) into an
+    // open-addressing table of node indices (0 = empty slot).
+    class CallTree
+    {
+    public:
+        CallTree() { Clear(); }
+
+        void Clear()
+        {
+            nodes.assign(1, Node{});
+            slots.assign(1024, 0);
+        }
+
+        // frames are innermost first
+        void Add(void* const* frames, USHORT count)
+        {
+            uint32_t node = 0;
+            for (USHORT i = count; i-- > 0;) {
+                uintptr_t address = reinterpret_cast<uintptr_t>(frames[i]);
+                if (i > 0) address--;   // attribute the call, not the instruction after it
+                node = Child(node, address);
+                nodes[node].total++;
+            }
+            if (node) nodes[node].self++;
+        }
+
+        const std::vector<Node>& Nodes() const { return nodes; }
+
+    private:
+        static size_t Hash(uint32_t parent, uintptr_t address)
+        {
+            const uint64_t h = uint64_t(address) * 0x9E3779B97F4A7C15ull ^ uint64_t(parent) * 0xC2B2AE3D27D4EB4Full;
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+
+        uint32_t Child(uint32_t parent, uintptr_t address)
+        {
+            if ((nodes.size() + 1) * 2 > slots.size()) Grow();
+
+            const size_t mask = slots.size() - 1;
+            for (size_t i = Hash(parent, address) & mask;; i = (i + 1) & mask) {
+                const uint32_t n = slots[i];
+                if (!n) {
+                    nodes.push_back(Node{ address, parent, 0, 0 });
+                    slots[i] = static_cast<uint32_t>(nodes.size() - 1);
+                    return slots[i];
+                }
+                if (nodes[n].parent == parent && nodes[n].address == address) return n;
+            }
+        }
+
+        void Grow()
+        {
+            slots.assign(slots.size() * 2, 0);
+            const size_t mask = slots.size() - 1;
+            for (uint32_t n = 1; n < nodes.size(); n++) {
+                size_t i = Hash(nodes[n].parent, nodes[n].address) & mask;
+                while (slots[i]) i = (i + 1) & mask;
+                slots[i] = n;
+            }
+        }
+
+        std::vector<Node>     nodes;
+        std::vector<uint32_t> slots;
+    };
+
+    std::atomic<bool>     g_running{ false };
+    HANDLE                g_thread = nullptr;
+    DWORD                 g_interval = 1000;   // microseconds
+    std::mutex            g_treeMutex;
+    CallTree              g_tree;
+    std::atomic<uint64_t> g_samples{ 0 };
+    std::atomic<uint64_t> g_ticks{ 0 };
+
+    // Runs while the thread is suspended: only a syscall and a memcpy, nothing that locks
+    size_t CopyStack(const CONTEXT& ctx, uint8_t* out)
+    {
+#ifdef _WIN64
+        const uintptr_t sp = ctx.Rsp;
+#else
+        const uintptr_t sp = ctx.Esp;
+#endif
+        MEMORY_BASIC_INFORMATION mbi{};
+        if (!VirtualQuery(reinterpret_cast<LPCVOID>(sp), &mbi, sizeof(mbi)) || mbi.State != MEM_COMMIT) return 0;
+
+        const uintptr_t high = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+        const size_t size = (std::min)(Profiler::kStackCopy, static_cast<size_t>(high - sp));
+        memcpy(out, reinterpret_cast<const void*>(sp), size);
+        return size;
+    }
+
+    // Function-level name used to group frames: module!Export, module!sub_RVA or module+RVA
+    std::string FunctionLabel(const Symbolizer::Symbol& symbol)
+    {
+        char buffer[64];
+        if (!symbol.module) {
+            snprintf(buffer, sizeof(buffer), "0x%p", reinterpret_cast<void*>(symbol.address));
+            return buffer;
+        }
+        if (symbol.name) return std::string(symbol.module) + "!" + symbol.name;
+        if (symbol.function) {
+            snprintf(buffer, sizeof(buffer), "!sub_%zX", static_cast<size_t>(symbol.function - symbol.moduleBase));
+        }
+        else {
+            snprintf(buffer, sizeof(buffer), "+0x%zX", static_cast<size_t>(symbol.address - symbol.moduleBase));
+        }
+        return symbol.module + std::string(buffer);
+    }
+
+    // Snapshot of the tree plus one symbol per node, resolved in a single batch
+    void SnapshotTree(std::vector<Node>& nodes, std::vector<Symbolizer::Symbol>& symbols)
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_treeMutex);
+            nodes = g_tree.Nodes();
+        }
+
+        std::vector<uintptr_t> addresses(nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++) addresses[i] = nodes[i].address;
+        symbols.resize(nodes.size());
+        Symbolizer::ResolveBatch(addresses.data(), addresses.size(), symbols.data());
+    }
+
+    // Minimal protobuf encoder for profile.proto
+    class ProtoWriter
+    {
+    public:
+        void Varint(uint64_t value)
+        {
+            while (value >= 0x80) {
+                data += static_cast<char>(value | 0x80);
+                value >>= 7;
+            }
+            data += static_cast<char>(value);
+        }
+
+        void UInt(int field, uint64_t value)
+        {
+            if (!value) return;
+            Varint(uint64_t(field) << 3);
+            Varint(value);
+        }
+
+        void Bytes(int field, const std::string& bytes)
+        {
+            Varint((uint64_t(field) << 3) | 2);
+            Varint(bytes.size());
+            data += bytes;
+        }
+
+        void Message(int field, const ProtoWriter& message) { Bytes(field, message.data); }
+
+        void Packed(int field, const std::vector<uint64_t>& values)
+        {
+            ProtoWriter packed;
+            for (uint64_t value : values) packed.Varint(value);
+            Bytes(field, packed.data);
+        }
+
+        std::string data;
+    };
+}
+
+bool Profiler::Start(DWORD intervalMicroseconds)
+{
+    if (g_thread) return false;
+
+    g_running = true;
+    g_interval = (std::max)(intervalMicroseconds, DWORD(100));
+    g_thread = CreateThread(nullptr, 0, SamplerThread, nullptr, 0, nullptr);
+    if (!g_thread) {
+        g_running = false;
+        return false;
+    }
+    SetThreadPriority(g_thread, THREAD_PRIORITY_HIGHEST);
+    return true;
+}
+
+void Profiler::Stop()
+{
+    g_running = false;
+    if (!g_thread) return;
+
+    WaitForSingleObject(g_thread, INFINITE);
+    CloseHandle(g_thread);
+    g_thread = nullptr;
+}
+
+bool Profiler::IsRunning()
+{
+    return g_running.load();
+}
+
+void Profiler::Reset()
+{
+    std::lock_guard<std::mutex> lock(g_treeMutex);
+    g_tree.Clear();
+    g_samples = 0;
+    g_ticks = 0;
+}
+
+uint64_t Profiler::GetSampleCount()
+{
+    return g_samples.load();
+}
+
+uint64_t Profiler::GetTicks()
+{
+    return g_ticks.load();
+}
+
+DWORD WINAPI Profiler::SamplerThread(LPVOID)
+{
+    // High-resolution timers need Windows 10 1803+; older systems get the default tick (~15.6 ms)
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer) timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+
+    // Twice the copy size: WalkCopy may read a little past the copy and must find zeros there
+    auto stack = static_cast<uint8_t*>(VirtualAlloc(nullptr, kStackCopy * 2, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (!stack) {
+        if (timer) CloseHandle(timer);
+        g_running = false;
+        return 1;
+    }
+
+    std::vector<HANDLE> threads;
+    ULONGLONG lastRefresh = 0;
+    size_t dirty = 0;   // bytes of the buffer that may be non-zero
+    CONTEXT ctx{};
+    void* frames[kMaxDepth];
+
+    while (g_running.load(std::memory_order_acquire)) {
+        LARGE_INTEGER due{};
+        due.QuadPart = -static_cast<LONGLONG>(g_interval) * 10;   // relative, 100 ns units
+        if (timer && SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+            WaitForSingleObject(timer, INFINITE);
+        }
+        else {
+            Sleep((std::max)(DWORD(1), g_interval / 1000));
+        }
+
+        // Re-enumerating every tick would cost more than the sampling itself
+        const ULONGLONG now = GetTickCount64();
+        if (now - lastRefresh >= kThreadRefreshMs) {
+            ProcessThreads::CloseAll(threads);
+            threads = ProcessThreads::OpenOthers(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION);
+            lastRefresh = now;
+        }
+        g_ticks.fetch_add(1, std::memory_order_relaxed);
+
+        for (HANDLE thread : threads) {
+            if (SuspendThread(thread) == (DWORD)-1) continue;
+
+            size_t copied = 0;
+            ctx.ContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
+            if (GetThreadContext(thread, &ctx)) {
+                copied = CopyStack(ctx, stack);
+            }
+            ResumeThread(thread);
+
+            if (!copied) continue;
+            if (dirty > copied) memset(stack + copied, 0, dirty - copied);
+            dirty = copied;
+
+            const USHORT count = Traceback::WalkCopy(ctx, stack, copied, frames, kMaxDepth);
+            if (count) {
+                std::lock_guard<std::mutex> lock(g_treeMutex);
+                g_tree.Add(frames, count);
+                g_samples.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    ProcessThreads::CloseAll(threads);
+    VirtualFree(stack, 0, MEM_RELEASE);
+    if (timer) CloseHandle(timer);
+    return 0;
+}
+
+bool Profiler::WriteFolded(const std::string& path)
+{
+    std::vector<Node> nodes;
+    std::vector<Symbolizer::Symbol> symbols;
+    SnapshotTree(nodes, symbols);
+
+    std::vector<std::string> labels(nodes.size());
+    for (size_t i = 1; i < nodes.size(); i++) labels[i] = FunctionLabel(symbols[i]);
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "[Profiler] Cannot open " << path << "\n";
+        return false;
+    }
+
+    std::vector<uint32_t> chain;
+    for (uint32_t n = 1; n < nodes.size(); n++) {
+        if (!nodes[n].self) continue;
+
+        chain.clear();
+        for (uint32_t m = n; m; m = nodes[m].parent) chain.push_back(m);
+
+        for (size_t i = chain.size(); i-- > 0;) {
+            out << labels[chain[i]] << (i ? ";" : " ");
+        }
+        out << nodes[n].self << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool Profiler::WritePprof(const std::string& path)
+{
+    std::vector<Node> nodes;
+    std::vector<Symbolizer::Symbol> symbols;
+    SnapshotTree(nodes, symbols);
+
+    std::vector<std::string> strings{ "" };
+    std::map<std::string, uint64_t> stringIds{ { "", 0 } };
+    auto str = [&](const std::string& s) {
+        auto [it, inserted] = stringIds.emplace(s, strings.size());
+        if (inserted) strings.push_back(s);
+        return it->second;
+    };
+
+    const uint64_t periodNs = uint64_t(g_interval) * 1000;
+    ProtoWriter profile;
+
+    auto valueType = [&](int field, const char* type, const char* unit) {
+        ProtoWriter vt;
+        vt.UInt(1, str(type));
+        vt.UInt(2, str(unit));
+        profile.Message(field, vt);
+    };
+    valueType(1, "samples", "count");
+    valueType(1, "cpu", "nanoseconds");
+
+    // Samples: one per node that ends a stack, locations leaf first (location id = node index)
+    std::vector<uint64_t> locations;
+    for (uint32_t n = 1; n < nodes.size(); n++) {
+        if (!nodes[n].self) continue;
+
+        locations.clear();
+        for (uint32_t m = n; m; m = nodes[m].parent) locations.push_back(m);
+
+        ProtoWriter sample;
+        sample.Packed(1, locations);
+        sample.Packed(2, { nodes[n].self, nodes[n].self * periodNs });
+        profile.Message(2, sample);
+    }
+
+    // Locations with one line each, pointing at a function per distinct label
+    std::map<std::string, uint64_t> functionIds;
+    std::vector<std::pair<std::string, const char*>> functions;   // label, module
+    for (uint32_t n = 1; n < nodes.size(); n++) {
+        const std::string label = FunctionLabel(symbols[n]);
+        auto [it, inserted] = functionIds.emplace(label, functions.size() + 1);
+        if (inserted) functions.emplace_back(label, symbols[n].module);
+
+        ProtoWriter line;
+        line.UInt(1, it->second);
+
+        ProtoWriter location;
+        location.UInt(1, n);
+        location.UInt(3, nodes[n].address);
+        location.Message(4, line);
+        profile.Message(4, location);
+    }
+
+    for (size_t i = 0; i < functions.size(); i++) {
+        ProtoWriter function;
+        function.UInt(1, i + 1);
+        function.UInt(2, str(functions[i].first));
+        function.UInt(3, str(functions[i].first));
+        function.UInt(4, str(functions[i].second ? functions[i].second : ""));
+        profile.Message(5, function);
+    }
+
+    profile.UInt(10, g_ticks.load() * periodNs);   // duration_nanos
+    valueType(11, "cpu", "nanoseconds");           // period_type
+    profile.UInt(12, periodNs);
+
+    // last: every string is interned by now
+    for (const std::string& s : strings) profile.Bytes(6, s);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[Profiler] Cannot open " << path << "\n";
+        return false;
+    }
+    out.write(profile.data.data(), std::streamsize(profile.data.size()));
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,389 @@
+#include "SignatureIndex.h"
+#include "InstructionDecoder.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t kCacheMagic = 0x4749534D;   // "MSIG"
+    constexpr uint32_t kCacheVersion = 1;
+
+    // Cache file: CacheHeader, Section[sectionCount], text padded to 4 bytes, uint32_t suffixes[textSize]
+    struct CacheHeader
+    {
+        ModuleCache::Header module;
+        uint32_t            depth;
+        uint32_t            sectionCount;
+        uint32_t            textSize;
+    };
+
+    ModuleCache g_cache("signatures", "sigidx", kCacheMagic, kCacheVersion);
+
+    size_t Align4(size_t value)
+    {
+        return (value + 3) & ~size_t(3);
+    }
+
+    // <0, 0, >0 like memcmp, comparing the first length bytes of the suffix at position with key;
+    // a suffix that ends first is the smaller one
+    int ComparePrefix(const uint8_t* text, size_t size, size_t position, const uint8_t* key, size_t length)
+    {
+        const size_t available = (std::min)(length, size - position);
+        const int c = memcmp(text + position, key, available);
+        if (c != 0) return c;
+        return available < length ? -1 : 0;
+    }
+}
+
+bool SignatureIndex::Pattern::Parse(const std::string& text, Pattern& out)
+{
+    out.bytes.clear();
+    out.mask.clear();
+
+    std::istringstream stream(text);
+    std::string byteStr;
+    while (stream >> byteStr) {
+        if (byteStr == "?" || byteStr == "??") {
+            out.bytes.push_back(0);
+            out.mask.push_back(false);
+            continue;
+        }
+        try {
+            out.bytes.push_back(static_cast<uint8_t>(std::stoul(byteStr, nullptr, 16)));
+            out.mask.push_back(true);
+        }
+        catch (...) {
+            return false;
+        }
+    }
+    return !out.bytes.empty();
+}
+
+std::string SignatureIndex::Pattern::ToString() const
+{
+    std::string result;
+    char hex[4];
+    for (size_t i = 0; i < bytes.size(); i++) {
+        if (i) result += ' ';
+        if (!mask[i]) {
+            result += "??";
+            continue;
+        }
+        snprintf(hex, sizeof(hex), "%02X", bytes[i]);
+        result += hex;
+    }
+    return result;
+}
+
+SignatureIndex::SignatureIndex(uintptr_t moduleBase)
+{
+    this->moduleBase = moduleBase ? moduleBase : reinterpret_cast<uintptr_t>(GetModuleHandle(NULL));
+    ReadImage();
+
+    const std::string path = g_cache.GetPath(module);
+    if (path.empty() || !MapCache(path)) {
+        Build();
+        if (!path.empty()) WriteCache(path);
+    }
+}
+
+void SignatureIndex::SetCacheDirectory(const std::string& directory)
+{
+    g_cache.SetDirectory(directory);
+}
+
+// Executable sections, base relocations and the identity of the module; the bytes are copied by Build
+void SignatureIndex::ReadImage()
+{
+    const IMAGE_NT_HEADERS* nt = ModuleCache::NtHeaders(moduleBase);
+    if (!nt || !ModuleCache::GetIdentity(moduleBase, module)) {
+        throw std::invalid_argument("SignatureIndex: not a PE image");
+    }
+
+    uint32_t offset = 0;
+    const IMAGE_SECTION_HEADER* section = IMAGE_FIRST_SECTION(nt);
+    for (WORD i = 0; i < nt->FileHeader.NumberOfSections; i++, section++) {
+        if (!(section->Characteristics & IMAGE_SCN_MEM_EXECUTE)) continue;
+
+        const uint32_t sectionSize = section->Misc.VirtualSize ? section->Misc.VirtualSize : section->SizeOfRawData;
+        if (!sectionSize) continue;
+        sections.push_back({ section->VirtualAddress, sectionSize, offset });
+        offset += sectionSize;
+    }
+    if (sections.empty()) {
+        throw std::invalid_argument("SignatureIndex: module has no executable sections");
+    }
+    size = offset;
+
+    const IMAGE_DATA_DIRECTORY& relocDir = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+    if (relocDir.VirtualAddress && relocDir.Size) {
+        uintptr_t block = moduleBase + relocDir.VirtualAddress;
+        const uintptr_t end = block + relocDir.Size;
+        while (block + sizeof(IMAGE_BASE_RELOCATION) <= end) {
+            auto header = reinterpret_cast<const IMAGE_BASE_RELOCATION*>(block);
+            if (header->SizeOfBlock < sizeof(IMAGE_BASE_RELOCATION)) break;
+
+            auto entries = reinterpret_cast<const WORD*>(header + 1);
+            const size_t count = (header->SizeOfBlock - sizeof(IMAGE_BASE_RELOCATION)) / sizeof(WORD);
+            for (size_t i = 0; i < count; i++) {
+                const WORD type = entries[i] >> 12;
+                const uint32_t width = type == IMAGE_REL_BASED_DIR64 ? 8 : type == IMAGE_REL_BASED_HIGHLOW ? 4 : 0;
+                const uint32_t rva = header->VirtualAddress + (entries[i] & 0xFFF);
+                for (uint32_t b = 0; b < width; b++) {
+                    relocations.push_back(rva + b);
+                }
+            }
+            block += header->SizeOfBlock;
+        }
+        std::sort(relocations.begin(), relocations.end());
+    }
+}
+
+// Copy the code, then sort suffixes: counting sort on the first two bytes, then each bucket
+// sorted on up to kMaxDepth bytes in parallel
+void SignatureIndex::Build()
+{
+    builtText.resize(size);
+    for (const Section& section : sections) {
+        memcpy(builtText.data() + section.offset, reinterpret_cast<const void*>(moduleBase + section.rva), section.size);
+    }
+    const uint8_t* data = builtText.data();
+    const size_t n = size;
+
+    auto key = [&](size_t i) { return (size_t(data[i]) << 8) | (i + 1 < n ? data[i + 1] : 0); };
+
+    std::vector<uint32_t> starts(65536 + 1, 0);
+    for (size_t i = 0; i < n; i++) starts[key(i) + 1]++;
+    for (size_t b = 0; b < 65536; b++) starts[b + 1] += starts[b];
+
+    builtSuffixes.resize(n);
+    std::vector<uint32_t> fill(starts.begin(), starts.end() - 1);
+    for (size_t i = 0; i < n; i++) builtSuffixes[fill[key(i)]++] = static_cast<uint32_t>(i);
+
+    Parallel::For(65536, [&](size_t bucket) {
+        const uint32_t first = starts[bucket], last = starts[bucket + 1];
+        if (last - first < 2) return;
+        std::sort(builtSuffixes.begin() + first, builtSuffixes.begin() + last, [&](uint32_t a, uint32_t b) {
+            const size_t la = (std::min)(kMaxDepth, n - a), lb = (std::min)(kMaxDepth, n - b);
+            const int c = memcmp(data + a, data + b, (std::min)(la, lb));
+            if (c != 0) return c < 0;
+            if (la != lb) return la < lb;
+            return a < b;
+        });
+    });
+
+    text = builtText.data();
+    suffixes = builtSuffixes.data();
+}
+
+bool SignatureIndex::MapCache(const std::string& path)
+{
+    if (!g_cache.Map(path, module, cache)) return false;
+
+    auto header = static_cast<const CacheHeader*>(cache.Data());
+    auto cachedSections = reinterpret_cast<const Section*>(header + 1);
+    bool valid = cache.Size() >= sizeof(CacheHeader) &&
+        header->depth == kMaxDepth && header->sectionCount == sections.size() && header->textSize == size;
+    if (valid) {
+        const uint64_t expected = sizeof(CacheHeader) + uint64_t(header->sectionCount) * sizeof(Section) +
+            Align4(header->textSize) + uint64_t(header->textSize) * sizeof(uint32_t);
+        valid = expected == cache.Size();
+    }
+    for (size_t i = 0; valid && i < sections.size(); i++) {
+        valid = cachedSections[i].rva == sections[i].rva && cachedSections[i].size == sections[i].size;
+    }
+    if (!valid) {
+        cache.Close();
+        return false;
+    }
+
+    text = reinterpret_cast<const uint8_t*>(cachedSections + header->sectionCount);
+    suffixes = reinterpret_cast<const uint32_t*>(text + Align4(size));
+    return true;
+}
+
+void SignatureIndex::WriteCache(const std::string& path) const
+{
+    const CacheHeader header{ g_cache.MakeHeader(module),
+        static_cast<uint32_t>(kMaxDepth), static_cast<uint32_t>(sections.size()), static_cast<uint32_t>(size) };
+    const char padding[4] = {};
+    g_cache.Write(path, {
+        { &header, sizeof(header) },
+        { sections.data(), sections.size() * sizeof(Section) },
+        { text, size },
+        { padding, Align4(size) - size },
+        { suffixes, size * sizeof(uint32_t) },
+    });
+}
+
+// Suffix array rows whose first length bytes equal key (length <= kMaxDepth)
+SignatureIndex::Range SignatureIndex::Search(const uint8_t* key, size_t length) const
+{
+    const uint32_t* first = std::lower_bound(suffixes, suffixes + size, key, [&](uint32_t position, const uint8_t* k) {
+        return ComparePrefix(text, size, position, k, length) < 0;
+    });
+    const uint32_t* last = std::upper_bound(first, suffixes + size, key, [&](const uint8_t* k, uint32_t position) {
+        return ComparePrefix(text, size, position, k, length) > 0;
+    });
+    return { size_t(first - suffixes), size_t(last - suffixes) };
+}
+
+// Masked compare at position; a match may not run from one section into the next
+bool SignatureIndex::Matches(size_t position, const Pattern& pattern) const
+{
+    const size_t length = pattern.bytes.size();
+    if (position + length > size) return false;
+
+    auto section = std::upper_bound(sections.begin(), sections.end(), position,
+        [](size_t p, const Section& s) { return p < s.offset; }) - 1;
+    if (position + length > size_t(section->offset) + section->size) return false;
+
+    for (size_t i = 0; i < length; i++) {
+        if (pattern.mask[i] && text[position + i] != pattern.bytes[i]) return false;
+    }
+    return true;
+}
+
+// Candidates come from the solid run with the fewest occurrences; each is then checked in full
+size_t SignatureIndex::Scan(const Pattern& pattern, size_t limit, std::vector<uintptr_t>* out) const
+{
+    const size_t length = pattern.bytes.size();
+    if (!length || length != pattern.mask.size() || length > size || !limit) return 0;
+
+    bool solid = false;
+    Range best{ 0, 0 };
+    size_t bestOffset = 0;
+    for (size_t start = 0; start < length;) {
+        if (!pattern.mask[start]) {
+            start++;
+            continue;
+        }
+        size_t end = start;
+        while (end < length && pattern.mask[end]) end++;
+
+        const Range range = Search(pattern.bytes.data() + start, (std::min)(end - start, kMaxDepth));
+        if (!solid || range.last - range.first < best.last - best.first) {
+            best = range;
+            bestOffset = start;
+            solid = true;
+        }
+        if (best.first == best.last) return 0;
+        start = end;
+    }
+
+    size_t count = 0;
+    auto accept = [&](size_t position) {
+        if (!Matches(position, pattern)) return false;
+        if (out) out->push_back(ToAddress(position));
+        return ++count >= limit;
+    };
+
+    if (!solid) {
+        for (size_t position = 0; position + length <= size; position++) {
+            if (accept(position)) break;
+        }
+        return count;
+    }
+
+    for (size_t row = best.first; row < best.last; row++) {
+        const size_t position = suffixes[row];
+        if (position < bestOffset) continue;
+        if (accept(position - bestOffset)) break;
+    }
+    return count;
+}
+
+size_t SignatureIndex::Count(const Pattern& pattern, size_t limit) const
+{
+    return Scan(pattern, limit, nullptr);
+}
+
+size_t SignatureIndex::Count(const std::string& pattern, size_t limit) const
+{
+    Pattern parsed;
+    return Pattern::Parse(pattern, parsed) ? Scan(parsed, limit, nullptr) : 0;
+}
+
+std::vector<uintptr_t> SignatureIndex::Find(const Pattern& pattern, size_t max) const
+{
+    std::vector<uintptr_t> results;
+    Scan(pattern, SIZE_MAX, &results);
+    std::sort(results.begin(), results.end());
+    if (results.size() > max) results.resize(max);
+    return results;
+}
+
+bool SignatureIndex::IsRelocated(uint32_t rva) const
+{
+    return std::binary_search(relocations.begin(), relocations.end(), rva);
+}
+
+std::string SignatureIndex::Generate(uintptr_t address, size_t maxLength) const
+{
+    size_t position = 0;
+    if (!ToPosition(address, position)) return {};
+
+    auto section = std::upper_bound(sections.begin(), sections.end(), position,
+        [](size_t p, const Section& s) { return p < s.offset; }) - 1;
+    const size_t sectionEnd = size_t(section->offset) + section->size;
+    const uint32_t rva = static_cast<uint32_t>(address - moduleBase);
+
+    Pattern pattern;
+    while (pattern.bytes.size() < maxLength && position + pattern.bytes.size() < sectionEnd) {
+        const size_t at = position + pattern.bytes.size();
+        DecodedInstruction insn;
+        if (!InstructionDecoder::Decode(text + at, (std::min)(sectionEnd - at, size_t(15)), insn)) break;
+
+        const size_t previous = pattern.bytes.size();
+        for (size_t i = 0; i < insn.length; i++) {
+            bool keep = !IsRelocated(rva + static_cast<uint32_t>(previous + i));
+            if (insn.ripRelative && i >= insn.dispOffset && i < size_t(insn.dispOffset) + insn.dispSize) keep = false;
+            if (insn.immSize && i >= insn.immOffset && i < size_t(insn.immOffset) + insn.immSize &&
+                (insn.relSize >= 4 || (!insn.relSize && insn.immSize >= 4))) keep = false;
+
+            pattern.bytes.push_back(text[at + i]);
+            pattern.mask.push_back(keep);
+        }
+        if (pattern.bytes.size() > maxLength) {
+            pattern.bytes.resize(maxLength);
+            pattern.mask.resize(maxLength);
+        }
+
+        if (Count(pattern, 2) != 1) continue;
+
+        // Unique with this instruction: find the shortest cut inside it that still is
+        for (size_t cut = previous + 1; cut <= pattern.bytes.size(); cut++) {
+            if (!pattern.mask[cut - 1]) continue;   // never end on a wildcard
+            Pattern shorter;
+            shorter.bytes.assign(pattern.bytes.begin(), pattern.bytes.begin() + cut);
+            shorter.mask.assign(pattern.mask.begin(), pattern.mask.begin() + cut);
+            if (Count(shorter, 2) == 1) return shorter.ToString();
+        }
+        return pattern.ToString();
+    }
+    return {};
+}
+
+uintptr_t SignatureIndex::ToAddress(size_t position) const
+{
+    auto section = std::upper_bound(sections.begin(), sections.end(), position,
+        [](size_t p, const Section& s) { return p < s.offset; }) - 1;
+    return moduleBase + section->rva + (position - section->offset);
+}
+
+bool SignatureIndex::ToPosition(uintptr_t address, size_t& position) const
+{
+    if (address < moduleBase) return false;
+    const uintptr_t rva = address - moduleBase;
+    for (const Section& section : sections) {
+        if (rva >= section.rva && rva < uintptr_t(section.rva) + section.size) {
+            position = section.offset + (rva - section.rva);
+            return true;
+        }
+    }
+    return false;
+}
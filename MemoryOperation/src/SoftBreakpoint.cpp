@@ -0,0 +1,258 @@
+#include "SoftBreakpoint.h"
+#include "CodeAllocator.h"
+#include "CodePatcher.h"
+#include "CodeRelocator.h"
+#include "Memory.h"
+#include <mutex>
+#include <stdio.h>
+
+std::atomic<const SoftBreakpoint::Table*> SoftBreakpoint::s_table{ nullptr };
+PVOID SoftBreakpoint::s_vehHandle = nullptr;
+
+namespace
+{
+    // Writers of s_table serialize here and retire the old table instead of freeing it
+    std::mutex               g_writeMutex;
+    std::vector<const void*> g_retiredTables;
+
+    // Breakpoint this thread lifted for a single-step, re-armed on the step exception
+    thread_local uintptr_t t_rearmAddress = 0;
+
+    // Handshake between writers and handler re-arms instead of a lock the handler could
+    // block on: a writer closes the gate and waits for re-arms in flight, a handler that
+    // finds the gate closed leaves the trap flag set and tries again on the next step.
+    // Afterwards the re-arm sees the writer's table, so a removed breakpoint stays removed.
+    std::atomic<bool> g_writing{ false };
+    std::atomic<int>  g_rearming{ 0 };
+
+    struct WriteGate
+    {
+        WriteGate()
+        {
+            g_writing.store(true);
+            while (g_rearming.load()) SwitchToThread();
+        }
+        ~WriteGate() { g_writing.store(false); }
+    };
+
+    uintptr_t GetPc(PCONTEXT ctx) {
+#ifdef _WIN64
+        return ctx->Rip;
+#else
+        return ctx->Eip;
+#endif
+    }
+
+    void SetPc(PCONTEXT ctx, uintptr_t pc) {
+#ifdef _WIN64
+        ctx->Rip = pc;
+#else
+        ctx->Eip = static_cast<DWORD>(pc);
+#endif
+    }
+}
+
+// Current table (an empty one before the first Publish)
+const SoftBreakpoint::Table& SoftBreakpoint::Current() {
+    static const Table empty{};
+    const Table* table = s_table.load(std::memory_order_acquire);
+    return table ? *table : empty;
+}
+
+// Swap in a copy of next; call with g_writeMutex held
+void SoftBreakpoint::Publish(const Table& next) {
+    const Table* old = s_table.exchange(new Table(next), std::memory_order_acq_rel);
+    if (old) {
+        g_retiredTables.push_back(old);
+    }
+}
+
+// Install the vectored exception handler (once); call with g_writeMutex held
+void SoftBreakpoint::InstallHandler() {
+    if (!s_vehHandle) {
+        s_vehHandle = AddVectoredExceptionHandler(1, ExceptionHandler);
+    }
+}
+
+// Copy of the instruction at address followed by a jump back to the next one,
+// null if it cannot be relocated
+uint8_t* SoftBreakpoint::Relocate(uintptr_t address) {
+    uint8_t* trampoline = CodeAllocator::Allocate(kTrampolineSize, address);
+    if (!trampoline) {
+        return nullptr;
+    }
+
+    size_t stolen = 0;
+    if (!CodeRelocator::Relocate(address, 1, trampoline, kTrampolineSize, reinterpret_cast<uintptr_t>(trampoline), &stolen)) {
+        return nullptr;
+    }
+    FlushInstructionCache(GetCurrentProcess(), trampoline, kTrampolineSize);
+    return trampoline;
+}
+
+// Writes the int3 back if address is still set; false if a writer holds the gate
+bool SoftBreakpoint::TryRearm(uintptr_t address) {
+    g_rearming.fetch_add(1);
+    if (g_writing.load()) {
+        g_rearming.fetch_sub(1);
+        return false;
+    }
+    if (Current().Contains(address)) {
+        CodePatcher::Write(address, &kInt3, 1);
+    }
+    g_rearming.fetch_sub(1);
+    return true;
+}
+
+LONG WINAPI SoftBreakpoint::ExceptionHandler(PEXCEPTION_POINTERS ex) {
+    const DWORD code = ex->ExceptionRecord->ExceptionCode;
+    PCONTEXT ctx = ex->ContextRecord;
+
+    if (code == EXCEPTION_BREAKPOINT) {
+        const uintptr_t pc = reinterpret_cast<uintptr_t>(ex->ExceptionRecord->ExceptionAddress);
+
+        // Stepped into another breakpoint with a re-arm still deferred: finish that first,
+        // re-executing the int3 until the writer is done, so t_rearmAddress is not overwritten
+        if (t_rearmAddress) {
+            if (!TryRearm(t_rearmAddress)) {
+                SetPc(ctx, pc);
+                return EXCEPTION_CONTINUE_EXECUTION;
+            }
+            t_rearmAddress = 0;
+            ctx->EFlags &= ~0x100;
+        }
+
+        const Point* point = Current().Find(pc);
+
+        if (!point) {
+            // Removed while this thread was trapping: the original byte is already back
+            if (*reinterpret_cast<const volatile uint8_t*>(pc) != kInt3) {
+                SetPc(ctx, pc);
+                return EXCEPTION_CONTINUE_EXECUTION;
+            }
+            return EXCEPTION_CONTINUE_SEARCH;
+        }
+
+        SetPc(ctx, pc);
+        if (point->callback) {
+            point->callback(ctx);
+        }
+
+        // The callback may have redirected the thread; otherwise run the displaced instruction
+        if (GetPc(ctx) == pc) {
+            if (point->trampoline) {
+                SetPc(ctx, reinterpret_cast<uintptr_t>(point->trampoline));
+            }
+            else {
+                CodePatcher::Write(pc, &point->original, 1);
+                ctx->EFlags |= 0x100;
+                t_rearmAddress = pc;
+            }
+        }
+        return EXCEPTION_CONTINUE_EXECUTION;
+    }
+
+    if (code == EXCEPTION_SINGLE_STEP && t_rearmAddress) {
+        // A writer is patching: keep the trap flag and retry after the next instruction
+        if (!TryRearm(t_rearmAddress)) {
+            return EXCEPTION_CONTINUE_EXECUTION;
+        }
+        t_rearmAddress = 0;
+        ctx->EFlags &= ~0x100; // Clear trap flag
+        return EXCEPTION_CONTINUE_EXECUTION;
+    }
+
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+bool SoftBreakpoint::Set(uintptr_t address, Callback callback) {
+    return SetBatch({ { address, callback } }) == 1;
+}
+
+size_t SoftBreakpoint::SetBatch(const std::vector<std::pair<uintptr_t, Callback>>& points) {
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+    InstallHandler();
+    if (!s_vehHandle) {
+        return 0;
+    }
+
+    WriteGate gate;
+    Table next = Current();
+    std::vector<CodePatcher::Edit> edits;
+    for (const auto& [address, callback] : points) {
+        if (!address || !callback || next.Contains(address) || Memory::IsBadRange(address, 1, false)) {
+            continue;
+        }
+
+        Point point;
+        point.callback = callback;
+        point.original = *reinterpret_cast<const uint8_t*>(address);
+        if (point.original == kInt3) {
+            continue; // someone else's breakpoint
+        }
+        point.trampoline = Relocate(address);
+
+        next.Insert(address, point);
+        edits.push_back({ address, &kInt3, 1 });
+    }
+    if (edits.empty()) {
+        return 0;
+    }
+
+    // The entries must be visible before the first int3 can be hit
+    Publish(next);
+
+    const size_t written = CodePatcher::WriteBatch(edits);
+    if (written != edits.size()) {
+        for (const CodePatcher::Edit& edit : edits) {
+            if (!edit.written) next.Erase(edit.address);
+        }
+        Publish(next);
+        printf("[SoftBreakpoint] Could not write %zu of %zu breakpoints\n", edits.size() - written, edits.size());
+    }
+    return written;
+}
+
+bool SoftBreakpoint::Remove(uintptr_t address) {
+    return RemoveBatch({ address }) == 1;
+}
+
+size_t SoftBreakpoint::RemoveBatch(const std::vector<uintptr_t>& addresses) {
+    std::lock_guard<std::mutex> lock(g_writeMutex);
+    WriteGate gate;
+
+    Table next = Current();
+    std::vector<CodePatcher::Edit> edits;
+    for (uintptr_t address : addresses) {
+        const Point* point = next.Find(address);
+        if (point) {
+            edits.push_back({ address, &point->original, 1 });
+        }
+    }
+    if (edits.empty()) {
+        return 0;
+    }
+
+    // Restore the bytes first: a thread trapping in between finds no entry, sees the
+    // original byte and simply re-executes it
+    CodePatcher::WriteBatch(edits);
+    for (const CodePatcher::Edit& edit : edits) {
+        next.Erase(edit.address);
+    }
+    Publish(next);
+    return edits.size();
+}
+
+void SoftBreakpoint::RemoveAll() {
+    std::vector<uintptr_t> addresses;
+    Current().ForEach([&](uintptr_t address, const Point&) { addresses.push_back(address); });
+    RemoveBatch(addresses);
+}
+
+bool SoftBreakpoint::IsSet(uintptr_t address) {
+    return Current().Contains(address);
+}
+
+size_t SoftBreakpoint::GetCount() {
+    return Current().Size();
+}
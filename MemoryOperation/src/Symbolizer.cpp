@@ -0,0 +1,268 @@
+#include "Symbolizer.h"
+#include "ModuleCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t kCacheMagic = 0x4D59534D;   // "MSYM"
+    constexpr uint32_t kCacheVersion = 1;
+    constexpr uint32_t kNoName = 0xFFFFFFFF;
+
+    // Cache file: CacheHeader, CacheEntry[count] sorted by rva, then the name blob
+    struct CacheHeader
+    {
+        ModuleCache::Header module;
+        uint32_t            count;
+        uint32_t            namesSize;
+    };
+
+    struct CacheEntry
+    {
+        uint32_t rva;
+        uint32_t name;   // offset into the name blob, kNoName if unnamed
+    };
+
+    struct ModuleIndex
+    {
+        uintptr_t             base = 0;
+        size_t                size = 0;
+        ModuleCache::Identity identity;
+
+        const CacheEntry* entries = nullptr;
+        uint32_t          count = 0;
+        const char*       names = nullptr;
+        uint32_t          namesSize = 0;
+
+        // backing storage: the mapped cache file, or the index built in memory
+        ModuleCache::Mapping    cache;
+        std::vector<CacheEntry> builtEntries;
+        std::string             builtNames;
+    };
+
+    std::mutex                                g_mutex;
+    std::vector<std::unique_ptr<ModuleIndex>> g_modules;   // sorted by base
+    ModuleCache                               g_cache("symbols", "symidx", kCacheMagic, kCacheVersion);
+
+    // Exports plus (x64) .pdata function starts, sorted by rva, one entry per rva
+    void BuildIndex(ModuleIndex& module, const IMAGE_NT_HEADERS* nt)
+    {
+        std::vector<CacheEntry>& entries = module.builtEntries;
+        std::string& names = module.builtNames;
+
+        const IMAGE_DATA_DIRECTORY& exportDir = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+        if (exportDir.VirtualAddress && exportDir.Size) {
+            auto exports = reinterpret_cast<const IMAGE_EXPORT_DIRECTORY*>(module.base + exportDir.VirtualAddress);
+            auto functions = reinterpret_cast<const DWORD*>(module.base + exports->AddressOfFunctions);
+            auto nameRvas = reinterpret_cast<const DWORD*>(module.base + exports->AddressOfNames);
+            auto ordinals = reinterpret_cast<const WORD*>(module.base + exports->AddressOfNameOrdinals);
+
+            for (DWORD i = 0; i < exports->NumberOfNames; i++) {
+                if (ordinals[i] >= exports->NumberOfFunctions) continue;
+                const DWORD rva = functions[ordinals[i]];
+
+                // forwarders point at a string inside the export directory
+                if (!rva || (rva >= exportDir.VirtualAddress && rva < exportDir.VirtualAddress + exportDir.Size)) continue;
+
+                entries.push_back({ rva, static_cast<uint32_t>(names.size()) });
+                names += reinterpret_cast<const char*>(module.base + nameRvas[i]);
+                names += '\0';
+            }
+        }
+
+#ifdef _WIN64
+        const IMAGE_DATA_DIRECTORY& pdata = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+        if (pdata.VirtualAddress && pdata.Size) {
+            auto functions = reinterpret_cast<const RUNTIME_FUNCTION*>(module.base + pdata.VirtualAddress);
+            const size_t count = pdata.Size / sizeof(RUNTIME_FUNCTION);
+            for (size_t i = 0; i < count; i++) {
+                entries.push_back({ functions[i].BeginAddress, kNoName });
+            }
+        }
+#endif
+
+        // named entries first within an rva so unique() keeps them
+        std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) {
+            if (a.rva != b.rva) return a.rva < b.rva;
+            return (a.name != kNoName) > (b.name != kNoName);
+        });
+        entries.erase(std::unique(entries.begin(), entries.end(),
+            [](const CacheEntry& a, const CacheEntry& b) { return a.rva == b.rva; }), entries.end());
+
+        module.entries = entries.data();
+        module.count = static_cast<uint32_t>(entries.size());
+        module.names = names.data();
+        module.namesSize = static_cast<uint32_t>(names.size());
+    }
+
+    bool MapCache(ModuleIndex& module, const std::string& path)
+    {
+        if (!g_cache.Map(path, module.identity, module.cache)) return false;
+
+        auto header = static_cast<const CacheHeader*>(module.cache.Data());
+        const uint64_t expected = sizeof(CacheHeader) + uint64_t(header->count) * sizeof(CacheEntry) + header->namesSize;
+        if (module.cache.Size() < sizeof(CacheHeader) || expected != module.cache.Size()) {
+            module.cache.Close();
+            return false;
+        }
+
+        module.entries = reinterpret_cast<const CacheEntry*>(header + 1);
+        module.count = header->count;
+        module.names = reinterpret_cast<const char*>(module.entries + module.count);
+        module.namesSize = header->namesSize;
+        return true;
+    }
+
+    void WriteCache(const ModuleIndex& module, const std::string& path)
+    {
+        const CacheHeader header{ g_cache.MakeHeader(module.identity), module.count, module.namesSize };
+        g_cache.Write(path, {
+            { &header, sizeof(header) },
+            { module.entries, size_t(module.count) * sizeof(CacheEntry) },
+            { module.names, module.namesSize },
+        });
+    }
+
+    ModuleIndex* LoadModule(HMODULE handle)
+    {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(handle);
+        const IMAGE_NT_HEADERS* nt = ModuleCache::NtHeaders(base);
+        if (!nt) return nullptr;
+
+        auto module = std::make_unique<ModuleIndex>();
+        module->base = base;
+        module->size = nt->OptionalHeader.SizeOfImage;
+        ModuleCache::GetIdentity(base, module->identity);
+
+        const std::string cachePath = g_cache.GetPath(module->identity);
+        if (cachePath.empty() || !MapCache(*module, cachePath)) {
+            BuildIndex(*module, nt);
+            if (!cachePath.empty()) WriteCache(*module, cachePath);
+        }
+
+        ModuleIndex* raw = module.get();
+        auto at = std::upper_bound(g_modules.begin(), g_modules.end(), base,
+            [](uintptr_t value, const std::unique_ptr<ModuleIndex>& m) { return value < m->base; });
+        g_modules.insert(at, std::move(module));
+        return raw;
+    }
+
+    // Module containing address, loading its index on first use; call with g_mutex held
+    ModuleIndex* FindModule(uintptr_t address)
+    {
+        auto at = std::upper_bound(g_modules.begin(), g_modules.end(), address,
+            [](uintptr_t value, const std::unique_ptr<ModuleIndex>& m) { return value < m->base; });
+        if (at != g_modules.begin()) {
+            ModuleIndex* module = (at - 1)->get();
+            if (address < module->base + module->size) return module;
+        }
+
+        HMODULE handle = nullptr;
+        if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+            reinterpret_cast<LPCSTR>(address), &handle) || !handle) {
+            return nullptr;
+        }
+        return LoadModule(handle);
+    }
+}
+
+bool Symbolizer::Resolve(uintptr_t address, Symbol& out)
+{
+    ResolveBatch(&address, 1, &out);
+    return out.module != nullptr;
+}
+
+void Symbolizer::ResolveBatch(const uintptr_t* addresses, size_t count, Symbol* out)
+{
+    if (!addresses || !out || !count) return;
+
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [addresses](uint32_t a, uint32_t b) { return addresses[a] < addresses[b]; });
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    // Addresses arrive in ascending order, so both the module and the position in its index
+    // only move forward; each search starts where the previous one ended
+    ModuleIndex* module = nullptr;
+    const CacheEntry* cursor = nullptr;
+    uintptr_t missFrom = 1, missTo = 0;   // last range known to be outside every module
+
+    for (uint32_t i : order) {
+        const uintptr_t address = addresses[i];
+        Symbol& symbol = out[i];
+        symbol = Symbol{};
+        symbol.address = address;
+
+        if (!module || address >= module->base + module->size) {
+            if (address >= missFrom && address < missTo) continue;
+
+            module = FindModule(address);
+            cursor = module ? module->entries : nullptr;
+            if (!module) {
+                // skip the rest of this region without asking the loader again
+                MEMORY_BASIC_INFORMATION mbi{};
+                if (VirtualQuery(reinterpret_cast<LPCVOID>(address), &mbi, sizeof(mbi))) {
+                    missFrom = reinterpret_cast<uintptr_t>(mbi.BaseAddress);
+                    missTo = missFrom + mbi.RegionSize;
+                }
+                continue;
+            }
+        }
+
+        symbol.module = module->identity.name.c_str();
+        symbol.moduleBase = module->base;
+
+        const uint32_t rva = static_cast<uint32_t>(address - module->base);
+        const CacheEntry* end = module->entries + module->count;
+        const CacheEntry* next = std::upper_bound(cursor, end, rva,
+            [](uint32_t value, const CacheEntry& e) { return value < e.rva; });
+        if (next == module->entries) continue;
+
+        const CacheEntry* entry = next - 1;
+        cursor = entry;
+        symbol.function = module->base + entry->rva;
+        if (entry->name != kNoName && entry->name < module->namesSize) {
+            symbol.name = module->names + entry->name;
+        }
+    }
+}
+
+std::string Symbolizer::Format(const Symbol& symbol)
+{
+    char buffer[64];
+    if (!symbol.module) {
+        snprintf(buffer, sizeof(buffer), "0x%p", reinterpret_cast<void*>(symbol.address));
+        return buffer;
+    }
+
+    std::string text = symbol.module;
+    if (symbol.name) {
+        snprintf(buffer, sizeof(buffer), "+0x%zX", static_cast<size_t>(symbol.address - symbol.function));
+        text += '!';
+        text += symbol.name;
+    }
+    else if (symbol.function) {
+        snprintf(buffer, sizeof(buffer), "!sub_%zX+0x%zX", static_cast<size_t>(symbol.function - symbol.moduleBase),
+            static_cast<size_t>(symbol.address - symbol.function));
+    }
+    else {
+        snprintf(buffer, sizeof(buffer), "+0x%zX", static_cast<size_t>(symbol.address - symbol.moduleBase));
+    }
+    return text + buffer;
+}
+
+void Symbolizer::SetCacheDirectory(const std::string& directory)
+{
+    g_cache.SetDirectory(directory);
+}
+
+void Symbolizer::Refresh()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_modules.clear();
+}
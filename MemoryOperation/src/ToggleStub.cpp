@@ -0,0 +1,76 @@
+#include "ToggleStub.h"
+#include "CodeAllocator.h"
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+    // disp32 operand of an absolute memory reference at 'at' (instruction ends at 'next'):
+    // RIP-relative on x64, a plain absolute address on x86
+    uint32_t MemOperand(uintptr_t next, uintptr_t target)
+    {
+#ifdef _WIN64
+        return static_cast<uint32_t>(static_cast<int32_t>(static_cast<intptr_t>(target - next)));
+#else
+        (void)next;
+        return static_cast<uint32_t>(target);
+#endif
+    }
+}
+
+uint8_t* ToggleStub::Allocate(uintptr_t nearAddress)
+{
+    uint8_t* raw = CodeAllocator::Allocate(kSize + kLine, nearAddress);
+    if (!raw) return nullptr;
+
+    const uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + kLine - 1) & ~uintptr_t(kLine - 1);
+    return reinterpret_cast<uint8_t*>(aligned);
+}
+
+bool ToggleStub::Emit(uint8_t* stub, uintptr_t detour, uintptr_t trampoline, bool enabled)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(stub);
+    if (!stub || (base & (kLine - 1)) || !detour) return false;
+
+    std::memset(stub, 0xCC, kSize);
+    std::memset(stub, 0, kLine);
+    stub[0] = enabled ? 1 : 0;
+
+    uint8_t* p = stub + kLine;
+    auto put32 = [&](uint32_t v) { std::memcpy(p, &v, 4); p += 4; };
+
+    // cmp byte ptr [flag], 0
+    *p++ = 0x80; *p++ = 0x3D;
+    put32(MemOperand(base + kLine + 7, base));
+    *p++ = 0x00;
+
+    // je +6 (over the first indirect jump)
+    *p++ = 0x74; *p++ = 0x06;
+
+    // jmp [detour slot]
+    *p++ = 0xFF; *p++ = 0x25;
+    put32(MemOperand(base + kLine + 15, base + kDetourSlot));
+
+    // jmp [trampoline slot]
+    *p++ = 0xFF; *p++ = 0x25;
+    put32(MemOperand(base + kLine + 21, base + kTrampolineSlot));
+
+    std::memcpy(stub + kDetourSlot, &detour, sizeof(detour));
+    std::memcpy(stub + kTrampolineSlot, &trampoline, sizeof(trampoline));
+    return true;
+}
+
+void ToggleStub::SetEnabled(uint8_t* stub, bool enabled)
+{
+    std::atomic_ref<uint8_t>(stub[0]).store(enabled ? 1 : 0, std::memory_order_release);
+}
+
+bool ToggleStub::IsEnabled(const uint8_t* stub)
+{
+    return std::atomic_ref<uint8_t>(const_cast<uint8_t&>(stub[0])).load(std::memory_order_acquire) != 0;
+}
+
+void ToggleStub::SetTrampoline(uint8_t* stub, uintptr_t trampoline)
+{
+    std::atomic_ref<uintptr_t>(*reinterpret_cast<uintptr_t*>(stub + kTrampolineSlot)).store(trampoline, std::memory_order_release);
+}
@@ -0,0 +1,161 @@
+#include "Traceback.h"
+
+// Stack range containing sp: the calling thread's limits when sp is on its stack,
+// otherwise the committed region around sp (another thread's stack)
+void Traceback::StackBounds(uintptr_t sp, uintptr_t& low, uintptr_t& high) {
+    ULONG_PTR threadLow = 0, threadHigh = 0;
+    GetCurrentThreadStackLimits(&threadLow, &threadHigh);
+    if (sp >= threadLow && sp < threadHigh) {
+        low = sp;
+        high = threadHigh;
+        return;
+    }
+
+    MEMORY_BASIC_INFORMATION mbi{};
+    if (VirtualQuery(reinterpret_cast<LPCVOID>(sp), &mbi, sizeof(mbi))) {
+        low = sp;
+        high = reinterpret_cast<uintptr_t>(mbi.BaseAddress) + mbi.RegionSize;
+        return;
+    }
+    low = high = 0;
+}
+
+// Walking a copy: stack pointers restored from the stack hold original addresses,
+// redirect them into the copy (readable = original + delta)
+void Traceback::Rebase(CONTEXT& ctx, uintptr_t stackLow, uintptr_t stackHigh, intptr_t delta) {
+    if (!delta) return;
+
+    const uintptr_t originalLow = stackLow - delta;
+    const uintptr_t originalHigh = stackHigh - delta;
+    auto rebase = [&](auto& reg) {
+        if (reg >= originalLow && reg < originalHigh) reg += delta;
+    };
+#ifdef _WIN64
+    rebase(ctx.Rsp); rebase(ctx.Rbp); rebase(ctx.Rbx); rebase(ctx.Rsi); rebase(ctx.Rdi);
+    rebase(ctx.R12); rebase(ctx.R13); rebase(ctx.R14); rebase(ctx.R15);
+#else
+    rebase(ctx.Esp); rebase(ctx.Ebp);
+#endif
+}
+
+USHORT Traceback::Unwind(CONTEXT& ctx, uintptr_t stackLow, uintptr_t stackHigh, intptr_t delta,
+    void** addresses, USHORT maxFrames, USHORT skip) {
+    USHORT count = 0;
+    Rebase(ctx, stackLow, stackHigh, delta);
+
+#ifdef _WIN64
+    // Caches the function table lookups of the modules seen during this walk
+    UNWIND_HISTORY_TABLE history{};
+
+    while (count < maxFrames && ctx.Rip) {
+        if (skip > 0) {
+            skip--;
+        }
+        else {
+            addresses[count++] = reinterpret_cast<void*>(ctx.Rip);
+        }
+
+        DWORD64 imageBase = 0;
+        PRUNTIME_FUNCTION function = RtlLookupFunctionEntry(ctx.Rip, &imageBase, &history);
+        if (function) {
+            PVOID handlerData = nullptr;
+            DWORD64 establisherFrame = 0;
+            RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, ctx.Rip, function, &ctx,
+                &handlerData, &establisherFrame, nullptr);
+            Rebase(ctx, stackLow, stackHigh, delta);
+        }
+        else {
+            // Leaf function (no unwind data): the return address is on top of the stack
+            if (ctx.Rsp < stackLow || ctx.Rsp + sizeof(DWORD64) > stackHigh) break;
+            ctx.Rip = *reinterpret_cast<const DWORD64*>(ctx.Rsp);
+            ctx.Rsp += sizeof(DWORD64);
+        }
+
+        if (ctx.Rsp < stackLow || ctx.Rsp >= stackHigh) break;
+    }
+#else
+    // x86 has no unwind tables; follow saved EBP links, which must move up the stack
+    uintptr_t pc = ctx.Eip;
+    uintptr_t frame = ctx.Ebp;
+
+    while (count < maxFrames && pc) {
+        if (skip > 0) {
+            skip--;
+        }
+        else {
+            addresses[count++] = reinterpret_cast<void*>(pc);
+        }
+
+        if (frame < stackLow || frame + 2 * sizeof(uintptr_t) > stackHigh || (frame & 3)) break;
+
+        const uintptr_t* links = reinterpret_cast<const uintptr_t*>(frame);
+        uintptr_t next = links[0];
+        pc = links[1];
+        if (delta && next - (stackLow - delta) < stackHigh - stackLow) next += delta;
+        if (next <= frame) break;
+        frame = next;
+    }
+#endif
+
+    return count;
+}
+
+#ifndef _WIN64
+#pragma optimize("y", off)   // the EBP walk starts from Walk's own frame
+#endif
+
+// Not inlined so the captured context is this function's own frame, skipped below
+__declspec(noinline) USHORT Traceback::Walk(void** addresses, USHORT maxFrames, USHORT skip) {
+    if (!addresses || !maxFrames) return 0;
+
+    CONTEXT ctx;
+    ctx.ContextFlags = CONTEXT_CONTROL | CONTEXT_INTEGER;
+    RtlCaptureContext(&ctx);
+
+    uintptr_t low = 0, high = 0;
+#ifdef _WIN64
+    StackBounds(ctx.Rsp, low, high);
+#else
+    StackBounds(ctx.Esp, low, high);
+#endif
+    return Unwind(ctx, low, high, 0, addresses, maxFrames, skip + 1);
+}
+
+__declspec(noinline) Traceback::TraceInfo Traceback::Capture(const USHORT skip, USHORT maxFrames) {
+    if (maxFrames > kMaxFrames) maxFrames = kMaxFrames;
+
+    auto traceback = TraceInfo{};
+    traceback.StackSize = Walk(traceback.Stack.data(), maxFrames, skip);
+    return traceback;
+}
+
+#ifndef _WIN64
+#pragma optimize("", on)
+#endif
+
+USHORT Traceback::Walk(const CONTEXT& ctx, void** addresses, USHORT maxFrames, USHORT skip) {
+    if (!addresses || !maxFrames) return 0;
+
+    CONTEXT copy = ctx;
+    uintptr_t low = 0, high = 0;
+#ifdef _WIN64
+    StackBounds(copy.Rsp, low, high);
+#else
+    StackBounds(copy.Esp, low, high);
+#endif
+    return Unwind(copy, low, high, 0, addresses, maxFrames, skip);
+}
+
+USHORT Traceback::WalkCopy(const CONTEXT& ctx, const void* stackCopy, size_t size,
+    void** addresses, USHORT maxFrames) {
+    if (!addresses || !maxFrames || !stackCopy || !size) return 0;
+
+    CONTEXT copy = ctx;
+    const uintptr_t low = reinterpret_cast<uintptr_t>(stackCopy);
+#ifdef _WIN64
+    const intptr_t delta = static_cast<intptr_t>(low - copy.Rsp);
+#else
+    const intptr_t delta = static_cast<intptr_t>(low - copy.Esp);
+#endif
+    return Unwind(copy, low, low + size, delta, addresses, maxFrames, 0);
+}
@@ -0,0 +1,124 @@
+#include "VTableHook.h"
+#include <cstring>
+
+namespace
+{
+    bool IsExecutable(uintptr_t address)
+    {
+        MEMORY_BASIC_INFORMATION mbi{};
+        if (!VirtualQuery(reinterpret_cast<LPCVOID>(address), &mbi, sizeof(mbi))) return false;
+        if (mbi.State != MEM_COMMIT) return false;
+        return (mbi.Protect & (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) != 0;
+    }
+}
+
+VTableHook::VTableHook(uintptr_t vtable, size_t index, uintptr_t replacement)
+{
+    if (!vtable) {
+        throw std::invalid_argument("VTableHook: null vtable");
+    }
+    Init(vtable + index * sizeof(uintptr_t), replacement);
+}
+
+
+VTableInstanceHook::VTableInstanceHook(uintptr_t object, size_t count)
+{
+    if (!object || Memory::IsBadRange(object, sizeof(uintptr_t), false)) {
+        throw std::invalid_argument("VTableInstanceHook: invalid object");
+    }
+
+    originalVTable = Memory::Read<uintptr_t>(object);
+    if (!count) count = CountMethods(originalVTable);
+    if (!count || Memory::IsBadRange(originalVTable - sizeof(uintptr_t), (count + 1) * sizeof(uintptr_t), false)) {
+        throw std::runtime_error("VTableInstanceHook: object has no readable vtable");
+    }
+
+    // Copy vtable[-1] too so RTTI (typeid, dynamic_cast) keeps working on the hooked object
+    table = std::make_unique<uintptr_t[]>(count + 1);
+    std::memcpy(table.get(), reinterpret_cast<const void*>(originalVTable - sizeof(uintptr_t)), (count + 1) * sizeof(uintptr_t));
+
+    methodCount = count;
+    address = object;
+    size = sizeof(uintptr_t);
+    original_bytes = Memory::ReadBytes(object, size);
+}
+
+VTableInstanceHook::~VTableInstanceHook()
+{
+    if (is_modified) {
+        try { Restore(); }
+        catch (...) {}
+    }
+}
+
+size_t VTableInstanceHook::CountMethods(uintptr_t vtable, size_t limit)
+{
+    size_t count = 0;
+    while (count < limit && !Memory::IsBadRange(vtable + count * sizeof(uintptr_t), sizeof(uintptr_t), false)
+        && IsExecutable(Memory::Read<uintptr_t>(vtable + count * sizeof(uintptr_t)))) {
+        ++count;
+    }
+    return count;
+}
+
+bool VTableInstanceHook::HookMethod(size_t index, uintptr_t replacement)
+{
+    if (index >= methodCount || !replacement) return false;
+
+    // the copy is ours and always writable; callers on other threads see old or new, never torn
+    InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&Slots()[index]), reinterpret_cast<PVOID>(replacement));
+    return true;
+}
+
+bool VTableInstanceHook::UnhookMethod(size_t index)
+{
+    if (index >= methodCount) return false;
+    return HookMethod(index, Memory::Read<uintptr_t>(originalVTable + index * sizeof(uintptr_t)));
+}
+
+uintptr_t VTableInstanceHook::GetOriginal(size_t index) const
+{
+    if (index >= methodCount) return 0;
+    return Memory::Read<uintptr_t>(originalVTable + index * sizeof(uintptr_t));
+}
+
+bool VTableInstanceHook::Apply()
+{
+    if (is_modified) {
+        return true;
+    }
+
+    // objects live in writable memory: no protection change needed
+    const PVOID seen = InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(address),
+        reinterpret_cast<PVOID>(Slots()), reinterpret_cast<PVOID>(originalVTable));
+    if (reinterpret_cast<uintptr_t>(seen) != originalVTable) {
+        std::cerr << "[VTableInstanceHook] Apply failed: vptr of 0x" << std::hex << address << " changed" << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = true;
+    return true;
+}
+
+bool VTableInstanceHook::Restore()
+{
+    if (!is_modified) {
+        return true;
+    }
+
+    if (Memory::IsBadRange(address, sizeof(uintptr_t), true)) {
+        std::cout << "Restore: object memory invalid, skipping\n";
+        is_modified = false;
+        return true;
+    }
+
+    const PVOID seen = InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(address),
+        reinterpret_cast<PVOID>(originalVTable), reinterpret_cast<PVOID>(Slots()));
+    if (reinterpret_cast<uintptr_t>(seen) != reinterpret_cast<uintptr_t>(Slots())) {
+        std::cerr << "[VTableInstanceHook] Restore failed: vptr of 0x" << std::hex << address << " was replaced" << std::dec << "\n";
+        return false;
+    }
+
+    is_modified = false;
+    return true;
+}
@@ -1,8 +1,11 @@
 #include "WinDetour.h"
+#include "ProcessThreads.h"
+#include "InstructionDecoder.h"
+#include "ToggleStub.h"
 
 
 
-WinDetour::WinDetour(PVOID* targetAddressRef, PVOID detourFunction)
+WinDetour::WinDetour(PVOID* targetAddressRef, PVOID detourFunction, bool softToggle)
 {
     if (!targetAddressRef || !*targetAddressRef || !detourFunction) {
         throw std::invalid_argument("WinDetour: null targetAddressRef/*targetAddressRef or detourFunction");
@@ -13,10 +16,26 @@ WinDetour::WinDetour(PVOID* targetAddressRef, PVOID detourFunction)
     HookAddress = detourFunction;               // your hook
     targetStorage = *targetAddressRef;           // current value (real entry before attach)
 
+    // Detours jumps to the stub; its disabled path learns the trampoline after attach
+    if (softToggle) {
+        toggle = ToggleStub::Allocate(reinterpret_cast<uintptr_t>(targetStorage));
+        if (!toggle || !ToggleStub::Emit(toggle, reinterpret_cast<uintptr_t>(detourFunction),
+                reinterpret_cast<uintptr_t>(targetStorage), true)) {
+            throw std::runtime_error("WinDetour: cannot allocate toggle stub");
+        }
+        FlushInstructionCache(GetCurrentProcess(), toggle, ToggleStub::kSize);
+        HookAddress = reinterpret_cast<PVOID>(ToggleStub::Entry(toggle));
+    }
+
     // Save bytes from the real entry (original function start)
     this->address = reinterpret_cast<uintptr_t>(targetStorage);
 
-    size = 20;
+    // Whole instructions Detours will move into its trampoline (it needs a 5-byte jmp)
+    size = 5;
+    if (!Memory::IsBadRange(this->address, 20, false)) {
+        if (size_t cover = InstructionDecoder::CoverLength(reinterpret_cast<const uint8_t*>(this->address), 5))
+            size = cover;
+    }
     auto bytes = Memory::ReadBytes(this->address, size);
 
 
@@ -49,37 +68,13 @@ bool WinDetour::Apply()
         return false;
     }
 
-    LONG rc = DetourTransactionBegin();
-    if (rc != NO_ERROR) {
-        std::cerr << "DetourTransactionBegin failed (rc=" << rc << ")\n";
-        return false;
-    }
-
-    rc = DetourUpdateThread(GetCurrentThread());
-    if (rc != NO_ERROR) {
-        std::cerr << "DetourUpdateThread failed (rc=" << rc << ")\n";
-        DetourTransactionAbort();
-        return false;
-    }
-
-    rc = DetourAttach((PVOID*)targetAddress, (PVOID)HookAddress);
-    if (rc != NO_ERROR) {
-        std::cerr << "DetourAttach failed (rc=" << rc << ")\n";
-        DetourTransactionAbort();
-        return false;
-    }
-
-    rc = DetourTransactionCommit();
-    if (rc != NO_ERROR) {
-        std::cerr << "DetourTransactionCommit failed (rc=" << rc << ")\n";
-        DetourTransactionAbort();
+    std::vector<LONG> errors;
+    if (!AttachBatch({ this }, &errors)) {
+        std::cerr << "DetourAttach failed (rc=" << errors[0] << ")\n";
         return false;
     }
 
     // After commit, targetStorage now points to the trampoline (the original function).
-    is_modified = true;
-
-   
     return true;
 }
 
@@ -90,30 +85,117 @@ bool WinDetour::Restore()
         return true;
     }
 
-    // Always mark as restored first to prevent multiple attempts
-    is_modified = false;
-
     if (!IsValid()) {
         std::cout << "Restore: target memory invalid, skipping detach\n";
+        is_modified = false;
         return true;
     }
 
-    __try {
-        LONG rc = DetourTransactionBegin();
-        if (rc == NO_ERROR) {
-            DetourUpdateThread(GetCurrentThread());
-            DetourDetach((PVOID*)targetAddress, (PVOID)HookAddress);
-            DetourTransactionCommit();
-        }
+    DetachBatch({ this });
+
+    // Mark as restored even if the detach failed, to prevent repeated attempts
+    is_modified = false;
+
+    std::cout << "Detour restoration attempted\n";
+    return true;
+}
+
+
+size_t WinDetour::AttachBatch(const std::vector<WinDetour*>& detours, std::vector<LONG>* errors)
+{
+    return CommitBatch(detours, true, errors);
+}
+
+size_t WinDetour::DetachBatch(const std::vector<WinDetour*>& detours, std::vector<LONG>* errors)
+{
+    return CommitBatch(detours, false, errors);
+}
+
+size_t WinDetour::CommitBatch(const std::vector<WinDetour*>& detours, bool attach, std::vector<LONG>* errors)
+{
+    std::vector<LONG> local;
+    auto& rc = errors ? *errors : local;
+    rc.assign(detours.size(), NO_ERROR);
+
+    // Only entries that actually change state take part in the transaction
+    std::vector<size_t> pending;
+    pending.reserve(detours.size());
+    for (size_t i = 0; i < detours.size(); ++i) {
+        WinDetour* d = detours[i];
+        if (!d || !d->targetAddress || !d->HookAddress) rc[i] = ERROR_INVALID_PARAMETER;
+        else if (d->is_modified == attach) continue;
+        else if (!attach && !d->IsValid()) rc[i] = ERROR_INVALID_BLOCK;
+        else pending.push_back(i);
     }
-    __except (EXCEPTION_EXECUTE_HANDLER) {
-        // Ignore all exceptions during restoration
+    if (pending.empty()) return 0;
+
+    std::vector<HANDLE> threads = ProcessThreads::OpenOthers(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_SET_CONTEXT);
+
+    // Detours keeps the first failing Attach/Detach as a pending error and refuses to commit,
+    // so drop the offender and retry the transaction with the remaining entries.
+    size_t changed = 0;
+    while (!pending.empty()) {
+        LONG result = DetourTransactionBegin();
+        if (result != NO_ERROR) {
+            for (size_t i : pending) rc[i] = result;
+            break;
+        }
+
+        for (HANDLE h : threads) DetourUpdateThread(h);
+
+        auto failed = pending.end();
+        for (auto it = pending.begin(); it != pending.end(); ++it) {
+            WinDetour* d = detours[*it];
+            result = attach ? DetourAttach(d->targetAddress, d->HookAddress)
+                            : DetourDetach(d->targetAddress, d->HookAddress);
+            if (result != NO_ERROR) {
+                rc[*it] = result;
+                failed = it;
+                break;
+            }
+        }
+
+        if (failed != pending.end()) {
+            DetourTransactionAbort();
+            pending.erase(failed);
+            continue;
+        }
+
+        result = DetourTransactionCommit();
+        if (result != NO_ERROR) {
+            for (size_t i : pending) rc[i] = result;
+            break;
+        }
+
+        for (size_t i : pending) {
+            WinDetour* d = detours[i];
+            d->is_modified = attach;
+            if (d->toggle) {
+                ToggleStub::SetTrampoline(d->toggle, reinterpret_cast<uintptr_t>(attach ? *d->targetAddress : d->targetStorage));
+            }
+        }
+        changed = pending.size();
+        break;
     }
 
-    std::cout << "Detour restoration attempted\n";
+    ProcessThreads::CloseAll(threads);
+    return changed;
+}
+
+bool WinDetour::SetEnabled(bool enabled)
+{
+    if (!toggle) return enabled ? Apply() : Restore();
+
+    if (enabled && !is_modified && !Apply()) return false;
+    ToggleStub::SetEnabled(toggle, enabled);
     return true;
 }
 
+bool WinDetour::IsEnabled() const
+{
+    return is_modified && (!toggle || ToggleStub::IsEnabled(toggle));
+}
+
 //bool WinDetour::Restore()
 //{
 //    if (!is_modified) {
@@ -0,0 +1,225 @@
+#include "XrefIndex.h"
+#include "InstructionDecoder.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t kCacheMagic = 0x4652584D;   // "MXRF"
+    constexpr uint32_t kCacheVersion = 1;
+    constexpr uint32_t kChunkSize = 256 * 1024;    // bytes of code per sweep work item
+
+    // Cache file: CacheHeader, then Entry[count] sorted by target
+    struct CacheHeader
+    {
+        ModuleCache::Header module;
+        uint32_t            count;
+    };
+
+    ModuleCache g_cache("xrefs", "xrefidx", kCacheMagic, kCacheVersion);
+}
+
+XrefIndex::XrefIndex(uintptr_t moduleBase)
+{
+    this->moduleBase = moduleBase ? moduleBase : reinterpret_cast<uintptr_t>(GetModuleHandle(NULL));
+    ReadImage();
+
+    const std::string path = g_cache.GetPath(module);
+    if (path.empty() || !MapCache(path)) {
+        Build();
+        if (!path.empty()) WriteCache(path);
+    }
+}
+
+void XrefIndex::SetCacheDirectory(const std::string& directory)
+{
+    g_cache.SetDirectory(directory);
+}
+
+void XrefIndex::ReadImage()
+{
+    const IMAGE_NT_HEADERS* nt = ModuleCache::NtHeaders(moduleBase);
+    if (!nt || !ModuleCache::GetIdentity(moduleBase, module)) {
+        throw std::invalid_argument("XrefIndex: not a PE image");
+    }
+
+    const IMAGE_SECTION_HEADER* section = IMAGE_FIRST_SECTION(nt);
+    for (WORD i = 0; i < nt->FileHeader.NumberOfSections; i++, section++) {
+        if (!(section->Characteristics & IMAGE_SCN_MEM_EXECUTE)) continue;
+
+        const uint32_t sectionSize = section->Misc.VirtualSize ? section->Misc.VirtualSize : section->SizeOfRawData;
+        if (sectionSize) sections.push_back({ section->VirtualAddress, sectionSize });
+    }
+    if (sections.empty()) {
+        throw std::invalid_argument("XrefIndex: module has no executable sections");
+    }
+
+    const IMAGE_DATA_DIRECTORY& relocDir = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_BASERELOC];
+    if (relocDir.VirtualAddress && relocDir.Size) {
+        uintptr_t block = moduleBase + relocDir.VirtualAddress;
+        const uintptr_t end = block + relocDir.Size;
+        while (block + sizeof(IMAGE_BASE_RELOCATION) <= end) {
+            auto header = reinterpret_cast<const IMAGE_BASE_RELOCATION*>(block);
+            if (header->SizeOfBlock < sizeof(IMAGE_BASE_RELOCATION)) break;
+
+            auto items = reinterpret_cast<const WORD*>(header + 1);
+            const size_t itemCount = (header->SizeOfBlock - sizeof(IMAGE_BASE_RELOCATION)) / sizeof(WORD);
+            for (size_t i = 0; i < itemCount; i++) {
+                const WORD type = items[i] >> 12;
+                const uint8_t width = type == IMAGE_REL_BASED_DIR64 ? 8 : type == IMAGE_REL_BASED_HIGHLOW ? 4 : 0;
+                if (width) relocations.push_back({ header->VirtualAddress + (items[i] & 0xFFFu), width });
+            }
+            block += header->SizeOfBlock;
+        }
+        std::sort(relocations.begin(), relocations.end(), [](const Relocation& a, const Relocation& b) { return a.rva < b.rva; });
+    }
+
+#ifdef _WIN64
+    const IMAGE_DATA_DIRECTORY& pdata = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+    if (pdata.VirtualAddress && pdata.Size) {
+        auto functions = reinterpret_cast<const RUNTIME_FUNCTION*>(moduleBase + pdata.VirtualAddress);
+        for (size_t i = 0; i < pdata.Size / sizeof(RUNTIME_FUNCTION); i++) {
+            functionStarts.push_back(functions[i].BeginAddress);
+        }
+        std::sort(functionStarts.begin(), functionStarts.end());
+    }
+#endif
+}
+
+// Linear sweep of [first, end); the last instruction may run past end, never past sectionEnd
+void XrefIndex::Sweep(uint32_t first, uint32_t end, uint32_t sectionEnd, std::vector<Entry>& out) const
+{
+    auto add = [&](uint64_t target, uint32_t source, Kind kind) {
+        if (target < module.sizeOfImage) out.push_back({ static_cast<uint32_t>(target), source, static_cast<uint8_t>(kind), {} });
+    };
+
+    auto reloc = std::lower_bound(relocations.begin(), relocations.end(), first,
+        [](const Relocation& r, uint32_t rva) { return r.rva < rva; });
+
+    uint32_t rva = first;
+    while (rva < end) {
+        const uint8_t* code = reinterpret_cast<const uint8_t*>(moduleBase + rva);
+        DecodedInstruction insn;
+        if (!InstructionDecoder::Decode(code, (std::min)(sectionEnd - rva, 15u), insn)) {
+            rva++;   // data or padding the decoder rejects; resynchronize on the next byte
+            continue;
+        }
+
+        // Computed in rva space: the module base cancels out of rel/rip targets
+        if (insn.relSize) {
+            const Kind kind = insn.flow == DecodedInstruction::Flow::Call ? Kind::Call :
+                insn.flow == DecodedInstruction::Flow::CondJump ? Kind::CondJump : Kind::Jump;
+            add(insn.BranchTarget(rva, code), rva, kind);
+        }
+        if (insn.ripRelative) {
+            add(insn.RipTarget(rva, code), rva, Kind::Data);
+        }
+
+        // Absolute addresses the loader fixed up inside this instruction
+        const uint32_t next = rva + insn.length;
+        while (reloc != relocations.end() && reloc->rva < rva) ++reloc;
+        for (auto r = reloc; r != relocations.end() && r->rva < next; ++r) {
+            uint64_t value = 0;
+            memcpy(&value, reinterpret_cast<const void*>(moduleBase + r->rva), r->width);
+            if (value >= moduleBase) add(value - moduleBase, rva, Kind::Data);
+        }
+        rva = next;
+    }
+}
+
+// Chunks of about kChunkSize per section, each moved forward to a function start when
+// .pdata has one, then swept in parallel and merged into one sorted index
+void XrefIndex::Build()
+{
+    struct Chunk
+    {
+        uint32_t first;
+        uint32_t end;
+        uint32_t sectionEnd;
+    };
+    std::vector<Chunk> chunks;
+    for (const Section& section : sections) {
+        const uint32_t sectionEnd = section.rva + section.size;
+        std::vector<uint32_t> bounds{ section.rva };
+        for (uint32_t nominal = section.rva + kChunkSize; nominal < sectionEnd; nominal += kChunkSize) {
+            uint32_t bound = nominal;
+            auto start = std::lower_bound(functionStarts.begin(), functionStarts.end(), nominal);
+            if (start != functionStarts.end() && *start < nominal + kChunkSize) bound = *start;
+            if (bound > bounds.back() && bound < sectionEnd) bounds.push_back(bound);
+        }
+        bounds.push_back(sectionEnd);
+
+        for (size_t i = 0; i + 1 < bounds.size(); i++) {
+            chunks.push_back({ bounds[i], bounds[i + 1], sectionEnd });
+        }
+    }
+
+    std::vector<std::vector<Entry>> found(chunks.size());
+    Parallel::For(chunks.size(), [&](size_t i) {
+        Sweep(chunks[i].first, chunks[i].end, chunks[i].sectionEnd, found[i]);
+    });
+
+    size_t total = 0;
+    for (const std::vector<Entry>& part : found) total += part.size();
+    built.reserve(total);
+    for (std::vector<Entry>& part : found) {
+        built.insert(built.end(), part.begin(), part.end());
+        std::vector<Entry>().swap(part);
+    }
+
+    Parallel::Sort(built, [](const Entry& a, const Entry& b) {
+        return a.target != b.target ? a.target < b.target : a.source < b.source;
+    });
+    entries = built.data();
+    count = built.size();
+}
+
+bool XrefIndex::MapCache(const std::string& path)
+{
+    if (!g_cache.Map(path, module, cache)) return false;
+
+    auto header = static_cast<const CacheHeader*>(cache.Data());
+    if (cache.Size() < sizeof(CacheHeader) || sizeof(CacheHeader) + uint64_t(header->count) * sizeof(Entry) != cache.Size()) {
+        cache.Close();
+        return false;
+    }
+
+    entries = reinterpret_cast<const Entry*>(header + 1);
+    count = header->count;
+    return true;
+}
+
+void XrefIndex::WriteCache(const std::string& path) const
+{
+    const CacheHeader header{ g_cache.MakeHeader(module), static_cast<uint32_t>(count) };
+    g_cache.Write(path, {
+        { &header, sizeof(header) },
+        { entries, count * sizeof(Entry) },
+    });
+}
+
+std::vector<XrefIndex::Xref> XrefIndex::To(uintptr_t target) const
+{
+    return ToRange(target, target + 1);
+}
+
+std::vector<XrefIndex::Xref> XrefIndex::ToRange(uintptr_t first, uintptr_t last) const
+{
+    std::vector<Xref> result;
+    const uintptr_t imageEnd = moduleBase + module.sizeOfImage;
+    first = (std::max)(first, moduleBase);
+    last = (std::min)(last, imageEnd);
+    if (first >= last) return result;
+
+    const uint32_t low = static_cast<uint32_t>(first - moduleBase);
+    const uint32_t high = static_cast<uint32_t>(last - moduleBase);
+    const Entry* begin = std::lower_bound(entries, entries + count, low,
+        [](const Entry& e, uint32_t rva) { return e.target < rva; });
+    for (const Entry* e = begin; e != entries + count && e->target < high; ++e) {
+        result.push_back({ moduleBase + e->source, moduleBase + e->target, static_cast<Kind>(e->kind) });
+    }
+    return result;
+}